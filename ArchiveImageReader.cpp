@@ -0,0 +1,118 @@
+#include "ArchiveImageReader.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+
+#include <archive.h>
+#include <archive_entry.h>
+
+// Entries larger than this are skipped instead of being read into memory.
+static const qint64 MaxEntrySize = 256 * 1024 * 1024;
+static const int ReadBlockSize = 64 * 1024;
+
+ArchiveImageReader::ArchiveImageReader(const ImageSource &source)
+    : reader(archive_read_new()), data(source.data), block(ReadBlockSize, Qt::Uninitialized), opened(false) {
+    for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+        imageSuffixes.insert(QString::fromLatin1(format).toLower());
+    }
+#ifdef WITH_PDF
+    imageSuffixes.insert("pdf");
+#endif
+    archive_read_support_filter_all(reader);
+    archive_read_support_format_zip(reader);
+    archive_read_support_format_tar(reader);
+    archive_read_support_format_gnutar(reader);
+
+    int status;
+    if (!source.filePath.isEmpty()) {
+        status = archive_read_open_filename(reader, QFile::encodeName(source.filePath).constData(), ReadBlockSize);
+    } else {
+        status = archive_read_open_memory(reader, data.constData(), size_t(data.size()));
+    }
+    opened = status == ARCHIVE_OK;
+}
+
+ArchiveImageReader::~ArchiveImageReader() {
+    archive_read_free(reader);
+}
+
+QStringList ArchiveImageReader::suffixes() {
+    return {"zip", "cbz", "tar", "tgz", "tar.gz", "tbz2", "tar.bz2", "txz", "tar.xz", "tar.zst"};
+}
+
+bool ArchiveImageReader::isArchive(const QString &filePath) {
+    const QString fileName = QFileInfo(filePath).fileName().toLower();
+    for (const QString &suffix : suffixes()) {
+        if (fileName.endsWith("." + suffix)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString ArchiveImageReader::errorString() const {
+    const char *message = archive_error_string(reader);
+    return message ? QString::fromLocal8Bit(message) : QString();
+}
+
+bool ArchiveImageReader::next(ArchiveEntry &entry) {
+    if (!opened) {
+        return false;
+    }
+    struct archive_entry *header;
+    for (;;) {
+        int status = archive_read_next_header(reader, &header);
+        if (status == ARCHIVE_EOF) {
+            return false;
+        }
+        if (status == ARCHIVE_WARN) {
+            qWarning() << "archive:" << errorString();
+        } else if (status != ARCHIVE_OK) {
+            qWarning() << "failed to read archive:" << errorString();
+            return false;
+        }
+
+        // Directories, links and non-image files are skipped, the reader
+        // moves past their data without decompressing it where it can.
+        const QString path = QString::fromUtf8(archive_entry_pathname_utf8(header)
+                                                   ? archive_entry_pathname_utf8(header)
+                                                   : archive_entry_pathname(header));
+        const QString suffix = QFileInfo(path).suffix().toLower();
+        if (archive_entry_filetype(header) != AE_IFREG || !imageSuffixes.contains(suffix)) {
+            continue;
+        }
+        if (archive_entry_size_is_set(header) && archive_entry_size(header) > MaxEntrySize) {
+            qWarning() << "skipping" << path << ": entry too large";
+            continue;
+        }
+
+        entry.path = path;
+        entry.format = suffix.toLatin1();
+        entry.data.clear();
+        if (archive_entry_size_is_set(header)) {
+            entry.data.reserve(int(archive_entry_size(header)));
+        }
+        la_ssize_t read;
+        while ((read = archive_read_data(reader, block.data(), size_t(block.size()))) > 0) {
+            if (entry.data.size() + read > MaxEntrySize) {
+                break;
+            }
+            entry.data.append(block.constData(), int(read));
+        }
+        if (read < 0) {
+            // Damaged or encrypted entries do not end the archive unless
+            // the reader gave up on it.
+            qWarning() << "failed to read" << path << ":" << errorString();
+            if (read == ARCHIVE_FATAL) {
+                return false;
+            }
+            continue;
+        }
+        if (read > 0) {
+            qWarning() << "skipping" << path << ": entry too large";
+            continue;
+        }
+        return true;
+    }
+}
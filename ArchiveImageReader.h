@@ -0,0 +1,51 @@
+#ifndef ARCHIVEIMAGEREADER_H
+#define ARCHIVEIMAGEREADER_H
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "ImageDecoder.h"
+
+struct archive;
+
+// Image stored in an archive, path is the one inside the archive.
+struct ArchiveEntry {
+    QString path;
+    QByteArray data;
+    QByteArray format; // from the file extension of the entry
+};
+
+// Streams the image entries out of a zip or (compressed) tar archive with
+// libarchive, in a file or in memory. Entries are never extracted to disk
+// and only the entry returned last is held in memory; entries that are no
+// image by their extension are skipped without being decompressed.
+class ArchiveImageReader {
+public:
+    explicit ArchiveImageReader(const ImageSource &source);
+    ~ArchiveImageReader();
+
+    // File extensions of the supported archives, e.g. to route files to it.
+    static QStringList suffixes();
+    static bool isArchive(const QString &filePath);
+
+    bool isOpen() const { return opened; }
+    QString errorString() const;
+
+    // Reads the next image entry. Returns false at the end of the archive
+    // or on an error that ends it.
+    bool next(ArchiveEntry &entry);
+
+private:
+    ArchiveImageReader(const ArchiveImageReader &) = delete;
+    ArchiveImageReader &operator=(const ArchiveImageReader &) = delete;
+
+    struct archive *reader;
+    QByteArray data; // keeps in-memory sources alive while reading
+    QByteArray block;
+    QSet<QString> imageSuffixes;
+    bool opened;
+};
+
+#endif // ARCHIVEIMAGEREADER_H
@@ -0,0 +1,116 @@
+#ifndef BASE64DECODER_H
+#define BASE64DECODER_H
+
+#include <QByteArray>
+#include <type_traits>
+
+// Incremental base64 decoder, input can be fed in arbitrary chunks of
+// 8 bit (char) or 16 bit (QString::utf16()) characters without building
+// an intermediate copy of the encoded text.
+class Base64Decoder {
+public:
+    // Decodes characters from [begin, end) and appends the bytes to out.
+    // Whitespace is skipped, decoding stops after the padding or at the first
+    // character outside of the base64 alphabet. Returns where it stopped.
+    template <typename Char>
+    const Char *feed(const Char *begin, const Char *end, QByteArray &out) {
+        const qsizetype start = out.size();
+        out.resize(start + (end - begin) / 4 * 3 + 3);
+        char *dst = out.data() + start;
+
+        const Char *it = begin;
+        while (it != end && !padded) {
+            // Whole groups of four characters are decoded at once.
+            if (count == 0 && end - it >= 4) {
+                int a = lookup(it[0]), b = lookup(it[1]), c = lookup(it[2]), d = lookup(it[3]);
+                if ((a | b | c | d) >= 0) {
+                    uint v = uint(a) << 18 | uint(b) << 12 | uint(c) << 6 | uint(d);
+                    *dst++ = char(v >> 16);
+                    *dst++ = char(v >> 8);
+                    *dst++ = char(v);
+                    it += 4;
+                    continue;
+                }
+            }
+            int v = lookup(*it);
+            if (v >= 0) {
+                bits = bits << 6 | uint(v);
+                if (++count == 4) {
+                    *dst++ = char(bits >> 16);
+                    *dst++ = char(bits >> 8);
+                    *dst++ = char(bits);
+                    bits = 0;
+                    count = 0;
+                }
+            } else if (v == Padding) {
+                dst = flush(dst);
+                padded = true;
+            } else if (v != Whitespace) {
+                break;
+            }
+            ++it;
+        }
+        while (padded && it != end && lookup(*it) == Padding) {
+            ++it;
+        }
+        out.resize(dst - out.data());
+        return it;
+    }
+
+    // Appends the bytes of an unpadded trailing group.
+    void finish(QByteArray &out) {
+        char tail[2];
+        out.append(tail, flush(tail) - tail);
+    }
+
+    // True once the padding has been seen, the encoded data is complete.
+    bool isPadded() const { return padded; }
+
+private:
+    enum { Invalid = -1, Whitespace = -2, Padding = -3 };
+
+    struct Table {
+        signed char values[256];
+        Table() {
+            for (int i = 0; i < 256; ++i) {
+                values[i] = Invalid;
+            }
+            const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int i = 0; i < 64; ++i) {
+                values[uchar(alphabet[i])] = static_cast<signed char>(i);
+            }
+            // URL safe alphabet
+            values[uchar('-')] = 62;
+            values[uchar('_')] = 63;
+            for (char c : {' ', '\t', '\r', '\n', '\f', '\v'}) {
+                values[uchar(c)] = Whitespace;
+            }
+            values[uchar('=')] = Padding;
+        }
+    };
+
+    template <typename Char>
+    static int lookup(Char c) {
+        static const Table table;
+        const uint u = static_cast<typename std::make_unsigned<Char>::type>(c);
+        return u < 256 ? int(table.values[u]) : int(Invalid);
+    }
+
+    char *flush(char *dst) {
+        if (count == 2) {
+            *dst++ = char(bits >> 4);
+        } else if (count == 3) {
+            *dst++ = char(bits >> 10);
+            *dst++ = char(bits >> 2);
+        }
+        bits = 0;
+        count = 0;
+        return dst;
+    }
+
+    uint bits = 0;
+    int count = 0;
+    bool padded = false;
+};
+
+#endif // BASE64DECODER_H
@@ -0,0 +1,81 @@
+#include "DataUrlScanner.h"
+#include "Base64Decoder.h"
+#include <QLatin1String>
+
+static bool isTokenChar(ushort c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '.' || c == '+' || c == '-' || c == '_';
+}
+
+static bool startsWithIgnoreCase(const ushort *it, const ushort *end, QLatin1String word) {
+    if (end - it < word.size()) {
+        return false;
+    }
+    for (int i = 0; i < word.size(); ++i) {
+        ushort c = it[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        if (c != ushort(word.at(i).unicode())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<DataUrlImage> DataUrlScanner::scan(const QString &text) {
+    static const QLatin1String prefix("data:image/");
+    static const QLatin1String base64(";base64,");
+
+    QList<DataUrlImage> images;
+    const ushort *begin = text.utf16();
+    const ushort *end = begin + text.size();
+    qsizetype pos = 0;
+    while ((pos = text.indexOf(prefix, pos, Qt::CaseInsensitive)) >= 0) {
+        const ushort *it = begin + pos + prefix.size();
+        while (it != end && isTokenChar(*it)) {
+            ++it;
+        }
+        // Skip media type parameters until the base64 marker.
+        bool isBase64 = false;
+        while (it != end && *it == ';') {
+            if (startsWithIgnoreCase(it, end, base64)) {
+                it += base64.size();
+                isBase64 = true;
+                break;
+            }
+            do {
+                ++it;
+            } while (it != end && (isTokenChar(*it) || *it == '='));
+        }
+        if (isBase64) {
+            DataUrlImage image;
+            Base64Decoder decoder;
+            it = decoder.feed(it, end, image.data);
+            decoder.finish(image.data);
+            if (!image.data.isEmpty()) {
+                image.format = sniffFormat(image.data);
+                images.append(image);
+            }
+        }
+        pos = it - begin;
+    }
+    return images;
+}
+
+QByteArray DataUrlScanner::sniffFormat(const QByteArray &data) {
+    if (data.startsWith("\x89PNG")) {
+        return "png";
+    } else if (data.startsWith("\xFF\xD8\xFF")) {
+        return "jpeg";
+    } else if (data.startsWith("GIF8")) {
+        return "gif";
+    } else if (data.startsWith("RIFF") && data.mid(8, 4) == "WEBP") {
+        return "webp";
+    } else if (data.startsWith(QByteArray("II*\0", 4)) || data.startsWith(QByteArray("MM\0*", 4))) {
+        return "tiff";
+    } else if (data.startsWith("BM")) {
+        return "bmp";
+    }
+    return QByteArray();
+}
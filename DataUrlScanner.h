@@ -0,0 +1,24 @@
+#ifndef DATAURLSCANNER_H
+#define DATAURLSCANNER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+
+// Decoded payload of a data:image/...;base64, URL.
+struct DataUrlImage {
+    QByteArray format; // sniffed from the payload, empty if unknown
+    QByteArray data;
+};
+
+class DataUrlScanner {
+public:
+    // Finds and decodes every base64 encoded image data URL of the text in
+    // a single pass over it.
+    static QList<DataUrlImage> scan(const QString &text);
+
+    // Image format name for QImageReader from the leading magic bytes.
+    static QByteArray sniffFormat(const QByteArray &data);
+};
+
+#endif // DATAURLSCANNER_H
@@ -0,0 +1,278 @@
+#include "DecodeHistory.h"
+#include <QCheckBox>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHeaderView>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSettings>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlQueryModel>
+#include <QStandardPaths>
+#include <QTableView>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QVBoxLayout>
+
+#include "OtpAuthUri.h"
+
+static const QFileDevice::Permissions OwnerOnly = QFileDevice::ReadOwner | QFileDevice::WriteOwner;
+
+static bool setting(const QString &key) {
+    return QSettings("qotpdecode", "qotpdecode").value(key, false).toBool();
+}
+
+static void setSetting(const QString &key, bool value) {
+    QSettings("qotpdecode", "qotpdecode").setValue(key, value);
+}
+
+// The secret of otpauth URIs, and the payload of migration batches (which
+// is nothing but secrets), are not stored unless the user asks for it.
+static QString withoutSecrets(const QString &text) {
+    const bool migration = text.startsWith("otpauth-migration://");
+    if (!migration && !OtpAuthUri::isOtpAuthUri(text)) {
+        return text;
+    }
+    QUrl url(text);
+    QUrlQuery query(url);
+    query.removeAllQueryItems(migration ? "data" : "secret");
+    url.setQuery(query);
+    return url.toString();
+}
+
+DecodeHistory::DecodeHistory(const QString &path) : connectionName("history"), fullText(false) {
+    // Created private to the user, SQLite gives its journal files the
+    // permissions of the database.
+    const QString directory = QFileInfo(path).absolutePath();
+    QDir().mkpath(directory);
+    QFile::setPermissions(directory, OwnerOnly | QFileDevice::ExeOwner);
+    QFile file(path);
+    if (file.open(QIODevice::ReadWrite)) {
+        file.setPermissions(OwnerOnly);
+        file.close();
+    }
+    database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    database.setDatabaseName(path);
+    if (!database.open() || !createSchema()) {
+        qWarning() << "failed to open decode history" << path << ":" << database.lastError().text();
+        database.close();
+    }
+}
+
+DecodeHistory::~DecodeHistory() {
+    database.close();
+    database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QString DecodeHistory::defaultPath() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("history.sqlite");
+}
+
+bool DecodeHistory::isRecording() {
+    return setting("history/record");
+}
+
+void DecodeHistory::setRecording(bool recording) {
+    setSetting("history/record", recording);
+}
+
+bool DecodeHistory::keepsSecrets() {
+    return setting("history/keepSecrets");
+}
+
+void DecodeHistory::setKeepSecrets(bool keep) {
+    setSetting("history/keepSecrets", keep);
+}
+
+bool DecodeHistory::createSchema() {
+    QSqlQuery query(database);
+    const QStringList statements = {
+        "PRAGMA journal_mode=WAL",
+        // Deleted entries are overwritten instead of lingering in free pages.
+        "PRAGMA secure_delete=ON",
+        "CREATE TABLE IF NOT EXISTS entries (id INTEGER PRIMARY KEY, time INTEGER NOT NULL, source TEXT, "
+        "format TEXT, text TEXT NOT NULL, code_hash TEXT NOT NULL, issuer TEXT, label TEXT)",
+        "CREATE INDEX IF NOT EXISTS entries_issuer ON entries (issuer)",
+        "CREATE INDEX IF NOT EXISTS entries_label ON entries (label)",
+        "CREATE INDEX IF NOT EXISTS entries_code_hash ON entries (code_hash)",
+    };
+    for (const QString &statement : statements) {
+        if (!query.exec(statement)) {
+            return false;
+        }
+    }
+
+    // External content FTS index, filled by a trigger since the log is
+    // only ever appended to.
+    fullText = query.exec("CREATE VIRTUAL TABLE IF NOT EXISTS entries_fts USING fts5("
+                          "text, issuer, label, source, content='entries', content_rowid='id')") &&
+               query.exec("CREATE TRIGGER IF NOT EXISTS entries_fts_insert AFTER INSERT ON entries BEGIN "
+                          "INSERT INTO entries_fts (rowid, text, issuer, label, source) "
+                          "VALUES (new.id, new.text, new.issuer, new.label, new.source); END");
+    if (!fullText) {
+        qDebug() << "no FTS5 in this SQLite, history search falls back to LIKE";
+    }
+    return true;
+}
+
+void DecodeHistory::record(const QString &source, const QList<ZXingQt::Result> &results) {
+    if (!isOpen()) {
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const bool keepSecrets = keepsSecrets();
+    database.transaction();
+    QSqlQuery query(database);
+    query.prepare("INSERT INTO entries (time, source, format, text, code_hash, issuer, label) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?)");
+    for (const ZXingQt::Result &result : results) {
+        if (!result.isValid()) {
+            continue;
+        }
+        QString issuer, label;
+        if (OtpAuthUri::isOtpAuthUri(result.text())) {
+            OtpAuthUri uri = OtpAuthUri::parse(result.text());
+            issuer = uri.issuer;
+            label = uri.label;
+        }
+        query.addBindValue(now);
+        query.addBindValue(source);
+        query.addBindValue(result.formatName());
+        query.addBindValue(keepSecrets ? result.text() : withoutSecrets(result.text()));
+        query.addBindValue(QString::fromLatin1(QCryptographicHash::hash(result.bytes(), QCryptographicHash::Sha256).toHex()));
+        query.addBindValue(issuer);
+        query.addBindValue(label);
+        if (!query.exec()) {
+            qWarning() << "failed to record decode:" << query.lastError().text();
+        }
+    }
+    database.commit();
+}
+
+bool DecodeHistory::clear() {
+    if (!isOpen()) {
+        return false;
+    }
+    QSqlQuery query(database);
+    bool cleared = query.exec("DELETE FROM entries");
+    if (cleared && fullText) {
+        cleared = query.exec("INSERT INTO entries_fts (entries_fts) VALUES ('delete-all')");
+    }
+    // VACUUM rewrites the file without the free pages, the checkpoint
+    // empties the write-ahead log.
+    if (!cleared || !query.exec("VACUUM") || !query.exec("PRAGMA wal_checkpoint(TRUNCATE)")) {
+        qWarning() << "failed to clear decode history:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void DecodeHistory::search(const QString &text, QSqlQueryModel *model) const {
+    const QString columns = "SELECT datetime(e.time / 1000, 'unixepoch', 'localtime') AS Time, e.issuer AS Issuer, "
+                            "e.label AS Label, e.source AS Source, e.text AS Text FROM entries e ";
+    const QStringList words = text.split(' ', Qt::SkipEmptyParts);
+    QSqlQuery query(database);
+    if (words.isEmpty()) {
+        query.prepare(columns + "ORDER BY e.id DESC");
+    } else if (fullText) {
+        // Every word as a quoted prefix, so operators and punctuation in
+        // the search text have no FTS syntax meaning.
+        QStringList terms;
+        for (QString word : words) {
+            terms << '"' + word.replace('"', "\"\"") + "\"*";
+        }
+        query.prepare(columns + "JOIN entries_fts f ON f.rowid = e.id WHERE entries_fts MATCH ? ORDER BY e.id DESC");
+        query.addBindValue(terms.join(' '));
+    } else {
+        QStringList conditions;
+        for (int i = 0; i < words.size(); ++i) {
+            conditions << "(e.text LIKE ? OR e.issuer LIKE ? OR e.label LIKE ? OR e.source LIKE ?)";
+        }
+        query.prepare(columns + "WHERE " + conditions.join(" AND ") + " ORDER BY e.id DESC");
+        for (const QString &word : words) {
+            for (int i = 0; i < 4; ++i) {
+                query.addBindValue('%' + word + '%');
+            }
+        }
+    }
+    if (!query.exec()) {
+        qWarning() << "history search failed:" << query.lastError().text();
+    }
+    model->setQuery(std::move(query));
+}
+
+HistoryDialog::HistoryDialog(DecodeHistory *history, QWidget *parent) : QDialog(parent), history(history) {
+    setWindowTitle("Decode History");
+    resize(720, 420);
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    searchEdit = new QLineEdit(this);
+    searchEdit->setPlaceholderText("Search issuer, label, source or text");
+    searchEdit->setClearButtonEnabled(true);
+    layout->addWidget(searchEdit);
+
+    // QTableView only creates what is visible and QSqlQueryModel fetches
+    // further rows as the view scrolls, large histories load in pieces.
+    model = new QSqlQueryModel(this);
+    tableView = new QTableView(this);
+    tableView->setModel(model);
+    tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    tableView->verticalHeader()->setVisible(false);
+    tableView->horizontalHeader()->setStretchLastSection(true);
+    layout->addWidget(tableView);
+
+    QHBoxLayout *settingsLayout = new QHBoxLayout;
+    recordCheckBox = new QCheckBox("Record decoded codes", this);
+    recordCheckBox->setChecked(DecodeHistory::isRecording());
+    settingsLayout->addWidget(recordCheckBox);
+    secretsCheckBox = new QCheckBox("Keep OTP secrets", this);
+    secretsCheckBox->setToolTip("Store otpauth:// URIs including their secret");
+    secretsCheckBox->setChecked(DecodeHistory::keepsSecrets());
+    secretsCheckBox->setEnabled(recordCheckBox->isChecked());
+    settingsLayout->addWidget(secretsCheckBox);
+    settingsLayout->addStretch();
+    QPushButton *clearButton = new QPushButton("Clear History", this);
+    settingsLayout->addWidget(clearButton);
+    layout->addLayout(settingsLayout);
+
+    connect(recordCheckBox, &QCheckBox::toggled, this, [this](bool checked) {
+        DecodeHistory::setRecording(checked);
+        secretsCheckBox->setEnabled(checked);
+    });
+    connect(secretsCheckBox, &QCheckBox::toggled, this, &DecodeHistory::setKeepSecrets);
+    connect(clearButton, &QPushButton::clicked, this, &HistoryDialog::clearHistory);
+
+    searchTimer.setSingleShot(true);
+    searchTimer.setInterval(150);
+    connect(searchEdit, &QLineEdit::textChanged, &searchTimer, QOverload<>::of(&QTimer::start));
+    connect(&searchTimer, &QTimer::timeout, this, &HistoryDialog::refresh);
+    connect(tableView, &QTableView::activated, this, [this](const QModelIndex &index) {
+        emit entryActivated(model->index(index.row(), 4).data().toString());
+    });
+    refresh();
+}
+
+void HistoryDialog::refresh() {
+    history->search(searchEdit->text(), model);
+}
+
+void HistoryDialog::clearHistory() {
+    if (QMessageBox::question(this, "Clear History", "Delete all entries of the history?") != QMessageBox::Yes) {
+        return;
+    }
+    // The model's query would keep the database busy.
+    model->clear();
+    if (!history->clear()) {
+        QMessageBox::warning(this, "Clear History", "The history could not be cleared.");
+    }
+    refresh();
+}
@@ -0,0 +1,81 @@
+#ifndef DECODEHISTORY_H
+#define DECODEHISTORY_H
+
+#include <QDialog>
+#include <QList>
+#include <QSqlDatabase>
+#include <QString>
+#include <QTimer>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+class QCheckBox;
+class QLineEdit;
+class QSqlQueryModel;
+class QTableView;
+
+// Persistent, append only log of decoded codes in an SQLite database, only
+// kept once the user turns it on. The secrets of otpauth URIs are left out
+// unless the user asks for them to be kept, and the database is readable by
+// the user only. Entries are indexed by issuer, label and a hash of the
+// payload, and a full text index (FTS5, plain LIKE where the SQLite build
+// lacks it) makes them searchable in milliseconds. Lives on the GUI thread.
+class DecodeHistory {
+public:
+    explicit DecodeHistory(const QString &path = defaultPath());
+    ~DecodeHistory();
+
+    static QString defaultPath();
+
+    // Both are user settings, off by default.
+    static bool isRecording();
+    static void setRecording(bool recording);
+    static bool keepsSecrets();
+    static void setKeepSecrets(bool keep);
+
+    bool isOpen() const { return database.isOpen(); }
+    void record(const QString &source, const QList<ZXingQt::Result> &results);
+
+    // Deletes every entry and compacts the database, so that nothing of
+    // them is left in the file.
+    bool clear();
+
+    // Fills the model with the entries matching every word of the search
+    // text, newest first. The model fetches rows as the view scrolls.
+    void search(const QString &text, QSqlQueryModel *model) const;
+
+private:
+    bool createSchema();
+
+    QString connectionName;
+    QSqlDatabase database;
+    bool fullText;
+};
+
+// Searchable view of the history, activating an entry reports its text. It
+// also holds the history settings and clears it.
+class HistoryDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    explicit HistoryDialog(DecodeHistory *history, QWidget *parent = nullptr);
+
+    // Runs the current search again, after new entries were recorded.
+    void refresh();
+
+signals:
+    void entryActivated(const QString &text);
+
+private:
+    void clearHistory();
+
+    DecodeHistory *history;
+    QLineEdit *searchEdit;
+    QCheckBox *recordCheckBox;
+    QCheckBox *secretsCheckBox;
+    QTableView *tableView;
+    QSqlQueryModel *model;
+    QTimer searchTimer;
+};
+
+#endif // DECODEHISTORY_H
@@ -0,0 +1,111 @@
+#include "DecodeScheduler.h"
+#include <QtMath>
+#include <time.h>
+
+DecodeScheduler::DecodeScheduler(double cpuBudget)
+    : cpuBudget(cpuBudget > 0 ? cpuBudget : 1.0), budgetReady(0), probeReady(0), idleUntil(0), idleInterval(0),
+      claims(0), cpuTotal(0), averageCost(0), frames(0), decodes(0), dropped(0) {
+    clock.start();
+}
+
+double DecodeScheduler::budgetFromString(const QString &spec, double defaultBudget) {
+    QString value = spec.trimmed();
+    const bool percent = value.endsWith('%');
+    if (percent) {
+        value.chop(1);
+    }
+    bool ok = false;
+    double budget = value.toDouble(&ok);
+    if (!ok || budget <= 0) {
+        return defaultBudget;
+    }
+    return percent ? budget / 100 : budget;
+}
+
+qint64 DecodeScheduler::threadCpuTime() {
+    struct timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+void DecodeScheduler::setBudget(double cores) {
+    if (cores > 0) {
+        cpuBudget = cores;
+    }
+}
+
+int DecodeScheduler::maxConcurrent() const {
+    return qMax(1, qCeil(cpuBudget));
+}
+
+DecodeScheduler::Admission DecodeScheduler::admit() {
+    const qint64 now = clock.elapsed();
+    if (claims < maxConcurrent() && now >= budgetReady && now >= idleUntil) {
+        ++claims;
+        return Decode;
+    }
+    if (now >= probeReady) {
+        return Probe;
+    }
+    ++dropped;
+    return Drop;
+}
+
+void DecodeScheduler::finished(qint64 cpuTime, Outcome outcome, bool claimed) {
+    const double cost = cpuTime / 1e6;
+    cpuTotal += cpuTime;
+    ++frames;
+    if (claimed) {
+        --claims;
+    }
+    const qint64 now = clock.elapsed();
+
+    switch (outcome) {
+    case Decoded:
+    case Located:
+    case Motion:
+    case Rejected:
+        // Something is in view or moving, decode again as soon as the
+        // budget allows.
+        idleInterval = 0;
+        idleUntil = 0;
+        break;
+    case Static:
+    case Empty:
+        idleInterval = qBound(qint64(IdleStep), 2 * idleInterval, qint64(MaxIdle));
+        idleUntil = now + idleInterval;
+        break;
+    case Deferred:
+        break;
+    }
+
+    if (outcome == Decoded || outcome == Located || outcome == Empty || (outcome == Motion && claimed)) {
+        averageCost = decodes == 0 ? cost : 0.9 * averageCost + 0.1 * cost;
+        ++decodes;
+    }
+
+    // The work started about its CPU time ago (it runs uncontended on a
+    // pool thread); cost / share after that the share allows the next frame
+    // of its kind. A share only ever waits for the frames it admitted
+    // itself, so it can not be pushed back without bound.
+    if (claimed) {
+        budgetReady = qMax(budgetReady, now - cost) + cost / (cpuBudget * (1 - ProbeShare));
+    } else {
+        probeReady = qMax(probeReady, now - cost) + cost / (cpuBudget * ProbeShare);
+    }
+}
+
+QString DecodeScheduler::report() const {
+    const qint64 elapsed = qMax(qint64(1), clock.elapsed());
+    return QString("decode scheduler: budget %1%, used %2%, %3 of %4 frames decoded, %5 dropped, "
+                   "average decode %6 ms, idle pause %7 ms")
+        .arg(cpuBudget * 100, 0, 'f', 0)
+        .arg(cpuTotal / 1e4 / elapsed, 0, 'f', 1)
+        .arg(decodes)
+        .arg(frames)
+        .arg(dropped)
+        .arg(averageCost, 0, 'f', 2)
+        .arg(idleInterval);
+}
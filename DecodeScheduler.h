@@ -0,0 +1,77 @@
+#ifndef DECODESCHEDULER_H
+#define DECODESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+// Paces the camera work of all feeds to a CPU budget, given as cores (0.25
+// is a quarter of one core). A quarter of the budget is set aside for
+// probes, frames that are only decoded from JPEG and checked by the frame
+// filter; the rest is reserved for frames that also go through zxing, so
+// probes can not crowd out decodes however expensive they are. After each
+// frame its CPU time is charged to its share and the next frame of that
+// kind is held back until the time fits in; frames arriving while neither
+// share allows one are dropped untouched. While the scene is static or
+// nothing is found an idle pause is added to decodes, it is dropped as soon
+// as a probe sees motion or a symbol is located. Used on the GUI thread only.
+class DecodeScheduler {
+public:
+    enum Outcome {
+        Static,   // frame skipped as unchanged
+        Rejected, // frame skipped as blurry or badly exposed, usually movement
+        Deferred, // worth decoding, not decoded for the budget
+        Empty,    // decoded, nothing found in an unchanged scene
+        Motion,   // the scene changed, nothing found (or not decoded)
+        Located,  // a symbol was located but not decoded
+        Decoded
+    };
+
+    // What may be done with the next frame.
+    enum Admission {
+        Drop,   // nothing, not even the JPEG decode
+        Probe,  // frame filter only
+        Decode  // frame filter and zxing
+    };
+
+    explicit DecodeScheduler(double cpuBudget = 1.0);
+
+    // Parses "25%" or "0.25", defaultBudget for an empty or invalid spec.
+    static double budgetFromString(const QString &spec, double defaultBudget = 1.0);
+    // CPU time consumed by the calling thread, in nanoseconds.
+    static qint64 threadCpuTime();
+
+    double budget() const { return cpuBudget; }
+    void setBudget(double cores);
+    // Decodes that may run at the same time, enough to use the budget.
+    int maxConcurrent() const;
+
+    // Decodes are admitted when the decode share and the idle pause allow
+    // one, else probes when the probe share does. Admitted frames are
+    // returned through finished(), claimed for decodes.
+    Admission admit();
+    void finished(qint64 cpuTime, Outcome outcome, bool claimed);
+
+    // Counters and measurements, for logging.
+    QString report() const;
+    int finishedFrames() const { return frames; }
+
+private:
+    static const int IdleStep = 60;    // first pause after an idle outcome, ms
+    static const int MaxIdle = 1000;
+    static constexpr double ProbeShare = 0.25;
+
+    double cpuBudget;
+    QElapsedTimer clock;
+    double budgetReady;  // clock milliseconds from which the decode share allows a decode
+    double probeReady;   // clock milliseconds from which the probe share allows a probe
+    qint64 idleUntil;    // clock milliseconds, end of the idle pause
+    qint64 idleInterval; // current idle pause after a decode
+    int claims;          // decodes claimed and not finished
+    qint64 cpuTotal;     // nanoseconds spent on all frames
+    double averageCost;  // milliseconds per decoded frame, moving average
+    int frames;
+    int decodes;
+    int dropped;
+};
+
+#endif // DECODESCHEDULER_H
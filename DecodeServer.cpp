@@ -0,0 +1,144 @@
+#include "DecodeServer.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <cstdio>
+
+DecodeServer::DecodeServer(QObject *parent) : QObject(parent), nextKey(0) {
+    connect(&server, &QLocalServer::newConnection, this, &DecodeServer::newConnection);
+    connect(&queue, &IngestQueue::sourceDecoded, this, &DecodeServer::sourceDecoded);
+}
+
+QString DecodeServer::defaultSocketName() {
+    QString runtimeDir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+    if (runtimeDir.isEmpty()) {
+        return "qotpdecode";
+    }
+    return QDir(runtimeDir).filePath("qotpdecode.sock");
+}
+
+bool DecodeServer::listen(const QString &name) {
+    // Only one daemon per socket, a stale socket file of a dead one is removed.
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(500)) {
+        qWarning() << "a decode daemon is already listening on" << name;
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    // The daemon reads any file it is asked for, so other users must not be
+    // able to connect, also when the socket falls back to /tmp.
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    if (!server.listen(name)) {
+        qWarning() << "failed to listen on" << name << ":" << server.errorString();
+        return false;
+    }
+    qDebug() << "listening on" << server.fullServerName();
+    return true;
+}
+
+void DecodeServer::newConnection() {
+    while (QLocalSocket *socket = server.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readRequests(socket); });
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void DecodeServer::readRequests(QLocalSocket *socket) {
+    QList<ImageSource> sources;
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError error;
+        QJsonObject request = QJsonDocument::fromJson(line, &error).object();
+        if (error.error != QJsonParseError::NoError) {
+            reply(socket, {{"error", error.errorString()}});
+            continue;
+        }
+
+        ImageSource source;
+        if (request.contains("path")) {
+            source.filePath = request.value("path").toString();
+            if (!QFileInfo(source.filePath).isFile()) {
+                reply(socket, {{"id", request.value("id")}, {"error", "no such file"}});
+                continue;
+            }
+        } else if (request.contains("data")) {
+            source.data = QByteArray::fromBase64(request.value("data").toString().toLatin1());
+        } else {
+            reply(socket, {{"id", request.value("id")}, {"error", "expected path or data"}});
+            continue;
+        }
+        source.name = QString::number(nextKey++);
+        requests.insert(source.name, {socket, request.value("id")});
+        sources.append(source);
+    }
+    if (!sources.isEmpty()) {
+        queue.enqueue(sources);
+    }
+}
+
+void DecodeServer::sourceDecoded(const QString &key, const QList<PageResult> &pages) {
+    Request request = requests.take(key);
+    if (request.socket) {
+        reply(request.socket, {{"id", request.id}, {"results", resultsToJson(pages)}});
+    }
+}
+
+void DecodeServer::reply(QLocalSocket *socket, const QJsonObject &response) {
+    socket->write(QJsonDocument(response).toJson(QJsonDocument::Compact) + "\n");
+}
+
+QJsonArray DecodeServer::resultsToJson(const QList<PageResult> &pages) {
+    QJsonArray results;
+    for (const PageResult &page : pages) {
+        for (const ZXingQt::Result &result : page.barcodes) {
+            results.append(QJsonObject{
+                {"page", page.page}, {"format", result.formatName()}, {"text", result.text()}});
+        }
+    }
+    return results;
+}
+
+int DecodeClient::run(const QStringList &inputs) {
+    QLocalSocket socket;
+    socket.connectToServer(socketName);
+    if (!socket.waitForConnected(1000)) {
+        qWarning() << "no decode daemon on" << socketName << ":" << socket.errorString();
+        return 1;
+    }
+
+    // All requests are sent at once, the daemon decodes them in parallel.
+    for (int i = 0; i < inputs.size(); ++i) {
+        QJsonObject request{{"id", i}};
+        if (inputs[i] == "-") {
+            QFile input;
+            input.open(stdin, QIODevice::ReadOnly);
+            request.insert("data", QString::fromLatin1(input.readAll().toBase64()));
+        } else {
+            request.insert("path", QFileInfo(inputs[i]).absoluteFilePath());
+        }
+        socket.write(QJsonDocument(request).toJson(QJsonDocument::Compact) + "\n");
+    }
+    socket.flush();
+
+    int pending = inputs.size();
+    while (pending > 0) {
+        if (!socket.canReadLine() && !socket.waitForReadyRead(-1)) {
+            qWarning() << "connection to decode daemon lost:" << socket.errorString();
+            return 1;
+        }
+        while (socket.canReadLine()) {
+            fputs(socket.readLine().constData(), stdout);
+            --pending;
+        }
+    }
+    fflush(stdout);
+    return 0;
+}
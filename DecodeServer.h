@@ -0,0 +1,62 @@
+#ifndef DECODESERVER_H
+#define DECODESERVER_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+
+#include "IngestQueue.h"
+
+// Resident decoder, clients send one JSON request per line:
+//   {"id": 1, "path": "/abs/path/image.png"}
+//   {"id": 2, "data": "<base64 encoded image>"}
+// and receive one JSON line per request, possibly out of order:
+//   {"id": 1, "results": [{"page": 0, "format": "QRCode", "text": "..."}]}
+class DecodeServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DecodeServer(QObject *parent = nullptr);
+
+    bool listen(const QString &name);
+
+    static QString defaultSocketName();
+    static QJsonArray resultsToJson(const QList<PageResult> &pages);
+
+private slots:
+    void newConnection();
+
+private:
+    struct Request {
+        QPointer<QLocalSocket> socket;
+        QJsonValue id;
+    };
+
+    void readRequests(QLocalSocket *socket);
+    void sourceDecoded(const QString &key, const QList<PageResult> &pages);
+    void reply(QLocalSocket *socket, const QJsonObject &response);
+
+    QLocalServer server;
+    IngestQueue queue;
+    QHash<QString, Request> requests;
+    quint64 nextKey;
+};
+
+// Command line side of the daemon: sends images and prints the responses.
+class DecodeClient {
+public:
+    explicit DecodeClient(const QString &socketName) : socketName(socketName) {}
+
+    // Inputs are file paths, "-" sends the image read from stdin.
+    int run(const QStringList &inputs);
+
+private:
+    QString socketName;
+};
+
+#endif // DECODESERVER_H
@@ -0,0 +1,59 @@
+#ifndef DECODESESSION_H
+#define DECODESESSION_H
+
+#include <QList>
+#include <atomic>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+// Decode work started on behalf of one camera (or other owner). Workers
+// observe the cancellation token between decode passes, so cancelling a
+// session stops its work after the pass that is currently running.
+class DecodeSession {
+public:
+    DecodeSession() {
+        // A cheap pass first, the exhaustive one only if it finds nothing.
+        passes.append(ZXingQt::ReaderOptions().setTryHarder(false).setTryRotate(false).setTryInvert(false));
+        // Symbols that are located but can not be decoded are only reported
+        // through decode()'s located flag.
+        passes.append(ZXingQt::ReaderOptions().setReturnErrors(true));
+    }
+
+    void cancel() { cancelled.store(true); }
+    bool isCancelled() const { return cancelled.load(); }
+
+    // At most one decode runs per session, tryBegin() claims it.
+    bool tryBegin() {
+        bool expected = false;
+        return !isCancelled() && busy.compare_exchange_strong(expected, true);
+    }
+    void end() { busy.store(false); }
+
+    template <typename Image>
+    QList<ZXingQt::Result> decode(const Image &image, bool *located = nullptr) const {
+        for (const ZXingQt::ReaderOptions &options : passes) {
+            if (isCancelled()) {
+                break;
+            }
+            QList<ZXingQt::Result> results;
+            for (const ZXingQt::Result &result : ZXingQt::ReadBarcodes(image, options)) {
+                if (result.isValid()) {
+                    results.append(result);
+                } else if (located) {
+                    *located = true;
+                }
+            }
+            if (!results.isEmpty()) {
+                return results;
+            }
+        }
+        return {};
+    }
+
+private:
+    QList<ZXingQt::ReaderOptions> passes;
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> busy{false};
+};
+
+#endif // DECODESESSION_H
@@ -0,0 +1,167 @@
+#include "FolderWatcher.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QStandardPaths>
+#include <QThreadPool>
+
+#include "MappedImage.h"
+#include "MimeImageScanner.h"
+#ifdef WITH_ARCHIVE
+#include "ArchiveImageReader.h"
+#endif
+
+// A file is decoded once size and modification time stayed the same for
+// StableChecks checks SettleInterval apart.
+static const int SettleInterval = 500;
+static const int StableChecks = 2;
+// Settled files waiting for the decoder, more stay candidates until the
+// backlog drains.
+static const int MaxReady = 1024;
+
+FolderWatcher::FolderWatcher(ResultExporter *exporter, const QString &journalPath, QObject *parent)
+    : QObject(parent), exporter(exporter), outstanding(0),
+      window(2 * QThreadPool::globalInstance()->maxThreadCount()) {
+    for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+        suffixes.insert(QString::fromLatin1(format).toLower());
+    }
+    for (const QString &suffix : MimeImageScanner::suffixes() + MappedImage::suffixes()) {
+        suffixes.insert(suffix);
+    }
+#ifdef WITH_PDF
+    suffixes.insert("pdf");
+#endif
+    loadJournal(journalPath);
+
+    settleTimer.setInterval(SettleInterval);
+    connect(&settleTimer, &QTimer::timeout, this, &FolderWatcher::checkCandidates);
+    connect(&watcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::scan);
+    connect(&queue, &IngestQueue::sourceDecoded, this, &FolderWatcher::sourceDecoded);
+}
+
+QString FolderWatcher::defaultJournalPath() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("watch-journal");
+}
+
+QString FolderWatcher::journalKey(const QFileInfo &info) {
+    return QString("%1\t%2\t%3")
+        .arg(info.lastModified().toMSecsSinceEpoch())
+        .arg(info.size())
+        .arg(info.absoluteFilePath());
+}
+
+void FolderWatcher::loadJournal(const QString &journalPath) {
+    // Entries of files that are gone or changed are dropped by rewriting
+    // the journal, it only grows with the files actually present.
+    QFile previous(journalPath);
+    if (previous.open(QIODevice::ReadOnly)) {
+        while (!previous.atEnd()) {
+            QString key = QString::fromUtf8(previous.readLine());
+            if (key.endsWith('\n')) {
+                key.chop(1);
+            }
+            if (key == journalKey(QFileInfo(key.section('\t', 2)))) {
+                journal.insert(key);
+            }
+        }
+        previous.close();
+    }
+
+    QDir().mkpath(QFileInfo(journalPath).absolutePath());
+    journalFile.setFileName(journalPath);
+    if (!journalFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "failed to open journal" << journalPath << ":" << journalFile.errorString();
+        return;
+    }
+    for (const QString &key : journal) {
+        journalFile.write(key.toUtf8() + "\n");
+    }
+    journalFile.flush();
+}
+
+bool FolderWatcher::isImageFile(const QFileInfo &info) const {
+#ifdef WITH_ARCHIVE
+    if (ArchiveImageReader::isArchive(info.fileName())) {
+        return true;
+    }
+#endif
+    return suffixes.contains(info.suffix().toLower());
+}
+
+bool FolderWatcher::watch(const QString &directory) {
+    if (!QFileInfo(directory).isDir() || !watcher.addPath(directory)) {
+        qWarning() << "can not watch" << directory;
+        return false;
+    }
+    scan(directory);
+    return true;
+}
+
+void FolderWatcher::scan(const QString &directory) {
+    const QFileInfoList entries = QDir(directory).entryInfoList(QDir::Files | QDir::Readable);
+    for (const QFileInfo &info : entries) {
+        const QString path = info.absoluteFilePath();
+        if (!isImageFile(info) || queued.contains(path) || candidates.contains(path) ||
+            journal.contains(journalKey(info))) {
+            continue;
+        }
+        candidates.insert(path, {info.size(), info.lastModified(), 0});
+    }
+    if (!candidates.isEmpty() && !settleTimer.isActive()) {
+        settleTimer.start();
+    }
+}
+
+void FolderWatcher::checkCandidates() {
+    for (auto it = candidates.begin(); it != candidates.end();) {
+        QFileInfo info(it.key());
+        if (!info.exists()) {
+            it = candidates.erase(it);
+            continue;
+        }
+        Stamp &stamp = it.value();
+        if (info.size() != stamp.size || info.lastModified() != stamp.modified) {
+            stamp = {info.size(), info.lastModified(), 0};
+        } else if (++stamp.stableChecks >= StableChecks && ready.size() < MaxReady) {
+            const QString key = journalKey(info);
+            if (!journal.contains(key)) {
+                ready.enqueue(it.key());
+                queued.insert(it.key(), key);
+            }
+            it = candidates.erase(it);
+            continue;
+        }
+        ++it;
+    }
+    if (candidates.isEmpty()) {
+        settleTimer.stop();
+    }
+    dispatch();
+}
+
+void FolderWatcher::dispatch() {
+    QList<ImageSource> sources;
+    while (outstanding + sources.size() < window && !ready.isEmpty()) {
+        ImageSource source;
+        source.filePath = ready.dequeue();
+        source.name = source.filePath;
+        sources.append(source);
+    }
+    outstanding += sources.size();
+    if (!sources.isEmpty()) {
+        queue.enqueue(sources);
+    }
+}
+
+void FolderWatcher::sourceDecoded(const QString &path, const QList<PageResult> &pages) {
+    --outstanding;
+    exporter->write(pages);
+    exporter->flush();
+
+    const QString key = queued.take(path);
+    journal.insert(key);
+    journalFile.write(key.toUtf8() + "\n");
+    journalFile.flush();
+    dispatch();
+}
@@ -0,0 +1,65 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+
+#include "IngestQueue.h"
+#include "ResultExporter.h"
+
+class QFileInfo;
+
+// Watches directories for new images (scanner and screenshot drop folders)
+// and decodes each once it has stopped changing. Only a window of files is
+// handed to the decoder at a time, files beyond a bounded backlog are
+// picked up later. Processed files are recorded in a journal, keyed by
+// path, size and modification time, so a restart skips them.
+class FolderWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    FolderWatcher(ResultExporter *exporter, const QString &journalPath, QObject *parent = nullptr);
+
+    bool watch(const QString &directory);
+
+    static QString defaultJournalPath();
+
+private:
+    // Size and modification time seen by the last check of a file that
+    // may still be written to.
+    struct Stamp {
+        qint64 size;
+        QDateTime modified;
+        int stableChecks;
+    };
+
+    void scan(const QString &directory);
+    void checkCandidates();
+    void dispatch();
+    void sourceDecoded(const QString &path, const QList<PageResult> &pages);
+    void loadJournal(const QString &journalPath);
+    bool isImageFile(const QFileInfo &info) const;
+    static QString journalKey(const QFileInfo &info);
+
+    ResultExporter *exporter;
+    QFileSystemWatcher watcher;
+    QTimer settleTimer;
+    IngestQueue queue;
+    QSet<QString> suffixes;
+
+    QHash<QString, Stamp> candidates; // seen, not yet settled
+    QQueue<QString> ready;            // settled, waiting for the decoder
+    QHash<QString, QString> queued;   // ready or decoding, path to journal key
+    QSet<QString> journal;
+    QFile journalFile;
+    int outstanding;
+    int window;
+};
+
+#endif // FOLDERWATCHER_H
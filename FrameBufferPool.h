@@ -0,0 +1,102 @@
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+// Size keyed pool of pixel buffers shared by the decode pipeline of all
+// cameras. A buffer is leased for one frame and goes back to the pool when
+// the lease ends, so once every frame size has been seen no per-frame pixel
+// buffers are allocated anymore. Smaller allocations per frame remain (result
+// lists, decode tasks, zxing's binarizer). Thread safe.
+class FrameBufferPool {
+public:
+    class Lease {
+    public:
+        Lease() : pool(nullptr), slot(-1), bytes(nullptr) {}
+        Lease(Lease &&other) : pool(other.pool), slot(other.slot), bytes(other.bytes) { other.pool = nullptr; }
+        Lease &operator=(Lease &&other) {
+            if (this != &other) {
+                release();
+                pool = other.pool;
+                slot = other.slot;
+                bytes = other.bytes;
+                other.pool = nullptr;
+            }
+            return *this;
+        }
+        ~Lease() { release(); }
+
+        uchar *data() const { return pool ? bytes : nullptr; }
+
+    private:
+        friend class FrameBufferPool;
+        Lease(FrameBufferPool *pool, int slot, uchar *bytes) : pool(pool), slot(slot), bytes(bytes) {}
+        void release() {
+            if (pool) {
+                pool->release(slot);
+                pool = nullptr;
+            }
+        }
+
+        FrameBufferPool *pool;
+        int slot;
+        uchar *bytes;
+    };
+
+    FrameBufferPool() : allocationCount(0) { slots.reserve(MaxSlots); }
+
+    // Leases a free buffer of exactly size bytes, allocating one only if
+    // there is none.
+    Lease acquire(int size) {
+        QMutexLocker locker(&mutex);
+        for (int i = 0; i < slots.size(); ++i) {
+            if (!slots[i].inUse && slots[i].buffer.size() == size) {
+                slots[i].inUse = true;
+                return Lease(this, i, slots[i].buffer.data());
+            }
+        }
+        // Once the pool is full, an unused buffer of another size (a camera
+        // changed its resolution) is replaced.
+        int slot = slots.size();
+        for (int i = 0; i < slots.size() && slot >= MaxSlots; ++i) {
+            slot = slots[i].inUse ? slot : i;
+        }
+        if (slot == slots.size()) {
+            slots.append(Slot());
+        }
+        slots[slot].buffer = QVector<uchar>(size);
+        slots[slot].inUse = true;
+        ++allocationCount;
+        return Lease(this, slot, slots[slot].buffer.data());
+    }
+
+    // Pixel buffers allocated by the pool so far, stays constant while
+    // scanning in a steady state. Other heap allocations are not counted.
+    int allocations() const {
+        QMutexLocker locker(&mutex);
+        return allocationCount;
+    }
+
+private:
+    struct Slot {
+        QVector<uchar> buffer;
+        bool inUse = false;
+    };
+
+    // Two buffers per camera are enough: the frame being decoded and the
+    // next one.
+    static const int MaxSlots = 32;
+
+    void release(int slot) {
+        QMutexLocker locker(&mutex);
+        slots[slot].inUse = false;
+    }
+
+    mutable QMutex mutex;
+    QVector<Slot> slots;
+    int allocationCount;
+};
+
+#endif // FRAMEBUFFERPOOL_H
@@ -0,0 +1,163 @@
+#include "FrameQualityFilter.h"
+#include <QStringList>
+#include <cstdlib>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+FrameQualityFilter::Thresholds FrameQualityFilter::Thresholds::fromString(const QString &spec) {
+    Thresholds thresholds;
+    for (const QString &item : spec.split(',', Qt::SkipEmptyParts)) {
+        QString key = item.section('=', 0, 0).trimmed();
+        double value = item.section('=', 1).toDouble();
+        if (key == "sharpness") {
+            thresholds.minSharpness = value;
+        } else if (key == "dark") {
+            thresholds.minBrightness = value;
+        } else if (key == "bright") {
+            thresholds.maxBrightness = value;
+        } else if (key == "motion") {
+            thresholds.minMotion = value;
+        } else if (key == "static") {
+            thresholds.maxStaticSkips = int(value);
+        }
+    }
+    return thresholds;
+}
+
+QString FrameQualityFilter::Thresholds::toString() const {
+    return QString("sharpness=%1,dark=%2,bright=%3,motion=%4,static=%5")
+        .arg(minSharpness).arg(minBrightness).arg(maxBrightness).arg(minMotion).arg(maxStaticSkips);
+}
+
+FrameQualityFilter::FrameQualityFilter(const Thresholds &thresholds)
+    : thresholds(thresholds), planeWidth(0), planeHeight(0), staticSkips(0), verdictCounts{0, 0, 0, 0, 0},
+      sharpness(0), brightness(0), motion(0) {
+}
+
+#ifdef QT_MULTIMEDIA_LIB
+FrameQualityFilter::Verdict FrameQualityFilter::check(const QVideoFrame &frame, bool mayDecode) {
+    Verdict verdict = mayDecode ? Decode : Deferred;
+    if (!ZXingQt::VisitImageView(frame, [&](const ZXing::ImageView &image) { verdict = check(image, mayDecode); })) {
+        ++verdictCounts[verdict];
+    }
+    return verdict;
+}
+#endif
+
+FrameQualityFilter::Verdict FrameQualityFilter::check(const ZXing::ImageView &image, bool mayDecode) {
+    subsample(image);
+    sharpness = laplacianVariance();
+    brightness = meanBrightness();
+    motion = decodedPlane.size() == plane.size() ? meanAbsoluteDifference() : -1;
+
+    Verdict verdict = Decode;
+    if (brightness < thresholds.minBrightness || brightness > thresholds.maxBrightness) {
+        verdict = SkipExposure;
+    } else if (sharpness < thresholds.minSharpness) {
+        verdict = SkipBlurry;
+    } else if (motion >= 0 && motion < thresholds.minMotion && staticSkips < thresholds.maxStaticSkips) {
+        verdict = SkipStatic;
+        ++staticSkips;
+    }
+
+    if (verdict == Decode && !mayDecode) {
+        verdict = Deferred;
+    } else if (verdict == Decode) {
+        staticSkips = 0;
+        decodedPlane.swap(plane);
+    }
+    ++verdictCounts[verdict];
+    return verdict;
+}
+
+int FrameQualityFilter::checkedFrames() const {
+    return verdictCounts[Decode] + verdictCounts[SkipBlurry] + verdictCounts[SkipExposure] + verdictCounts[SkipStatic] +
+           verdictCounts[Deferred];
+}
+
+QString FrameQualityFilter::report() const {
+    return QString("frame filter [%1]: decoded %2, skipped %3 blurry, %4 exposure, %5 static, %6 over budget; "
+                   "last sharpness %7, brightness %8, motion %9")
+        .arg(thresholds.toString())
+        .arg(verdictCounts[Decode]).arg(verdictCounts[SkipBlurry])
+        .arg(verdictCounts[SkipExposure]).arg(verdictCounts[SkipStatic]).arg(verdictCounts[Deferred])
+        .arg(sharpness, 0, 'f', 1).arg(brightness, 0, 'f', 1).arg(motion, 0, 'f', 2);
+}
+
+void FrameQualityFilter::subsample(const ZXing::ImageView &image) {
+    // Green is a good enough stand-in for the luma of RGB formats.
+    const int channel = ZXing::GreenIndex(image.format());
+    const int stepX = qMax(1, image.width() / PlaneEdge);
+    const int stepY = qMax(1, image.height() / PlaneEdge);
+    planeWidth = image.width() / stepX;
+    planeHeight = image.height() / stepY;
+    plane.resize(planeWidth * planeHeight);
+
+    uchar *out = plane.data();
+    for (int y = 0; y < planeHeight; ++y) {
+        const uint8_t *row = image.data(0, y * stepY) + channel;
+        const int stride = stepX * image.pixStride();
+        for (int x = 0; x < planeWidth; ++x) {
+            *out++ = row[x * stride];
+        }
+    }
+}
+
+double FrameQualityFilter::laplacianVariance() const {
+    if (planeWidth < 3 || planeHeight < 3) {
+        return 0;
+    }
+    // Integer sums over contiguous rows, the inner loop vectorizes.
+    qint64 sum = 0;
+    qint64 sumSquares = 0;
+    const uchar *p = plane.constData();
+    for (int y = 1; y < planeHeight - 1; ++y) {
+        const uchar *up = p + (y - 1) * planeWidth;
+        const uchar *row = p + y * planeWidth;
+        const uchar *down = p + (y + 1) * planeWidth;
+        int rowSum = 0;
+        qint64 rowSquares = 0;
+        for (int x = 1; x < planeWidth - 1; ++x) {
+            int laplacian = 4 * row[x] - row[x - 1] - row[x + 1] - up[x] - down[x];
+            rowSum += laplacian;
+            rowSquares += laplacian * laplacian;
+        }
+        sum += rowSum;
+        sumSquares += rowSquares;
+    }
+    const double count = double(planeWidth - 2) * (planeHeight - 2);
+    const double mean = sum / count;
+    return sumSquares / count - mean * mean;
+}
+
+double FrameQualityFilter::meanBrightness() const {
+    qint64 sum = 0;
+    for (uchar value : plane) {
+        sum += value;
+    }
+    return plane.isEmpty() ? 0 : double(sum) / plane.size();
+}
+
+double FrameQualityFilter::meanAbsoluteDifference() const {
+    const uchar *a = plane.constData();
+    const uchar *b = decodedPlane.constData();
+    const int size = plane.size();
+    quint64 sum = 0;
+    int i = 0;
+#ifdef __SSE2__
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= size; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    // The lane sums of a subsampled plane fit in 32 bit, unlike
+    // _mm_cvtsi128_si64 this also builds for 32 bit x86.
+    sum = quint32(_mm_cvtsi128_si32(acc)) + quint32(_mm_cvtsi128_si32(_mm_unpackhi_epi64(acc, acc)));
+#endif
+    for (; i < size; ++i) {
+        sum += std::abs(int(a[i]) - int(b[i]));
+    }
+    return size ? double(sum) / size : 0;
+}
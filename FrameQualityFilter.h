@@ -0,0 +1,67 @@
+#ifndef FRAMEQUALITYFILTER_H
+#define FRAMEQUALITYFILTER_H
+
+#include <QString>
+#include <QVector>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+// Cheap look at a subsampled luma plane of each camera frame to decide
+// whether a full decode is worthwhile: frames that are blurry (refocusing,
+// moving hand), badly exposed or unchanged since the last decode are
+// skipped. One filter per camera, it must not be used concurrently.
+class FrameQualityFilter {
+public:
+    struct Thresholds {
+        double minSharpness = 30;  // variance of the Laplacian
+        double minBrightness = 20; // mean luma
+        double maxBrightness = 235;
+        double minMotion = 2;      // mean absolute luma change since the last decode
+        int maxStaticSkips = 10;   // unchanged frames are still decoded every n-th time
+
+        // Parses "sharpness=30,dark=20,bright=235,motion=2,static=10",
+        // missing keys keep their defaults.
+        static Thresholds fromString(const QString &spec);
+        QString toString() const;
+    };
+
+    // Deferred: worth decoding, but the caller may not decode now. The frame
+    // does not become the reference for motion then.
+    enum Verdict { Decode, SkipBlurry, SkipExposure, SkipStatic, Deferred };
+
+    explicit FrameQualityFilter(const Thresholds &thresholds = Thresholds());
+
+    // Frames that can not be measured are always decoded (or deferred).
+#ifdef QT_MULTIMEDIA_LIB
+    Verdict check(const QVideoFrame &frame, bool mayDecode = true);
+#endif
+    Verdict check(const ZXing::ImageView &image, bool mayDecode = true);
+
+    // Whether the last checked frame differs from the last decoded one.
+    bool sawMotion() const { return motion >= thresholds.minMotion; }
+
+    // Counters and the measurements of the last frame, for logging.
+    QString report() const;
+    int checkedFrames() const;
+
+private:
+    static const int PlaneEdge = 160;
+
+    void subsample(const ZXing::ImageView &image);
+    double laplacianVariance() const;
+    double meanAbsoluteDifference() const;
+    double meanBrightness() const;
+
+    Thresholds thresholds;
+    QVector<uchar> plane;
+    QVector<uchar> decodedPlane;
+    int planeWidth;
+    int planeHeight;
+    int staticSkips;
+    int verdictCounts[5];
+    double sharpness;
+    double brightness;
+    double motion;
+};
+
+#endif // FRAMEQUALITYFILTER_H
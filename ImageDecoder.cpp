@@ -0,0 +1,480 @@
+#include "ImageDecoder.h"
+#include <QBuffer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QImageReader>
+#include <QPair>
+#include <QSet>
+#include <QtMath>
+#include <QStringList>
+#include <QtConcurrent>
+
+#include "MappedImage.h"
+#include "MimeImageScanner.h"
+
+#ifdef WITH_ARCHIVE
+#include "ArchiveImageReader.h"
+#endif
+#ifdef WITH_PDF
+#include <QSharedPointer>
+#include "PdfRasterizer.h"
+#endif
+
+using namespace ZXingQt;
+
+ImageDecoder::ImageDecoder()
+    : readerOptions(ReaderOptions()
+                        .setFormats(ZXing::BarcodeFormat::QRCode)
+                        .setTryInvert(true)
+                        .setTextMode(ZXing::TextMode::HRI)
+                        .setMaxNumberOfSymbols(10)),
+      framesInFlight(3), scanEdge(2048) {
+}
+
+namespace {
+
+// QImageReader together with the buffer an in-memory source is read from.
+struct SourceReader {
+    explicit SourceReader(const ImageSource &source) {
+        if (source.filePath.isEmpty()) {
+            buffer.setData(source.data);
+            buffer.open(QIODevice::ReadOnly);
+            reader.setDevice(&buffer);
+            reader.setFormat(source.format);
+        } else {
+            reader.setFileName(source.filePath);
+        }
+    }
+
+    QBuffer buffer;
+    QImageReader reader;
+};
+
+} // namespace
+
+// Reads a single frame again, optionally only the given region of it.
+static QImage readFrame(const ImageSource &source, int page, const QRect &clipRect) {
+    SourceReader sourceReader(source);
+    QImageReader &reader = sourceReader.reader;
+    if (page > 0 && !reader.jumpToImage(page)) {
+        for (int i = 0; i < page; ++i) {
+            if (reader.supportsAnimation() ? reader.read().isNull() : !reader.jumpToNextImage()) {
+                return QImage();
+            }
+        }
+    }
+    if (clipRect.isValid()) {
+        reader.setClipRect(clipRect);
+    }
+    return reader.read();
+}
+
+static QRect boundingRect(const Position &position) {
+    int left = position[0].x(), right = left;
+    int top = position[0].y(), bottom = top;
+    for (const QPoint &point : position) {
+        left = qMin(left, point.x());
+        right = qMax(right, point.x());
+        top = qMin(top, point.y());
+        bottom = qMax(bottom, point.y());
+    }
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+QList<Result> ImageDecoder::decodeImage(const QImage &image) const {
+    return ReadBarcodes(image, readerOptions);
+}
+
+QList<PageResult> ImageDecoder::decodeFile(const QString &filePath) const {
+    return decodeSource({filePath, QByteArray(), QByteArray(), QString()});
+}
+
+QList<PageResult> ImageDecoder::decodeData(const QByteArray &data, const QByteArray &format) const {
+    return decodeSource({QString(), data, format, QString()});
+}
+
+// Results of a full resolution decode, plus those of the reduced scan it
+// did not find again.
+static QList<Result> mergeResults(QList<Result> full, const QList<Result> &reduced) {
+    QSet<QString> texts;
+    for (const Result &result : full) {
+        texts.insert(result.text());
+    }
+    for (const Result &result : reduced) {
+        if (!texts.contains(result.text())) {
+            full.append(result);
+        }
+    }
+    return full;
+}
+
+QList<Result> ImageDecoder::decodeFrame(const ImageSource &source, int page, const QImage &frame,
+                                        const QSize &fullSize) const {
+    if (!fullSize.isValid() || frame.size() == fullSize) {
+        return ReadBarcodes(frame, readerOptions);
+    }
+
+    // Symbols that were located but could not be decoded at reduced
+    // resolution are retried on a full resolution crop around them. If a
+    // crop does not resolve its symbol, the whole frame is decoded at full
+    // resolution after all. Once the reduced scan found codes and located
+    // nothing else, symbols too small to be located at reduced size are not
+    // searched for; that is the price of skipping the full decode.
+    QList<Result> results;
+    QList<QRect> candidates;
+    for (const Result &result : ReadBarcodes(frame, ReaderOptions(readerOptions).setReturnErrors(true))) {
+        if (result.isValid()) {
+            results.append(result);
+        } else {
+            candidates.append(boundingRect(result.position()));
+        }
+    }
+    if (results.isEmpty() && candidates.isEmpty()) {
+        return ReadBarcodes(readFrame(source, page, QRect()), readerOptions);
+    }
+
+    const qreal scaleX = qreal(fullSize.width()) / frame.width();
+    const qreal scaleY = qreal(fullSize.height()) / frame.height();
+    for (const QRect &candidate : candidates) {
+        QRect clipRect(qFloor(candidate.x() * scaleX), qFloor(candidate.y() * scaleY),
+                       qCeil(candidate.width() * scaleX), qCeil(candidate.height() * scaleY));
+        int margin = qMax(clipRect.width(), clipRect.height()) / 4;
+        clipRect = clipRect.adjusted(-margin, -margin, margin, margin) & QRect(QPoint(0, 0), fullSize);
+        const QList<Result> resolved = ReadBarcodes(readFrame(source, page, clipRect), readerOptions);
+        if (resolved.isEmpty()) {
+            return mergeResults(ReadBarcodes(readFrame(source, page, QRect()), readerOptions), results);
+        }
+        results += resolved;
+    }
+    return results;
+}
+
+// Like decodeFrame (with the same fallback) for images mapped from disk: the
+// reduced resolution scan
+// reads every n-th pixel and crops are views into the full image, so gray
+// images are never copied (zxing converts RGB to a luma copy itself).
+QList<Result> ImageDecoder::decodeView(const ZXing::ImageView &image) const {
+    const int scale = qCeil(qreal(qMax(image.width(), image.height())) / scanEdge);
+    if (scale <= 1) {
+        return ReadBarcodes(image, readerOptions);
+    }
+
+    QList<Result> results;
+    QList<QRect> candidates;
+    for (const Result &result : ReadBarcodes(image.subsampled(scale), ReaderOptions(readerOptions).setReturnErrors(true))) {
+        if (result.isValid()) {
+            results.append(result);
+        } else {
+            candidates.append(boundingRect(result.position()));
+        }
+    }
+    if (results.isEmpty() && candidates.isEmpty()) {
+        return ReadBarcodes(image, readerOptions);
+    }
+
+    const QRect bounds(0, 0, image.width(), image.height());
+    for (const QRect &candidate : candidates) {
+        QRect clipRect(candidate.x() * scale, candidate.y() * scale, candidate.width() * scale, candidate.height() * scale);
+        int margin = qMax(clipRect.width(), clipRect.height()) / 4;
+        clipRect = clipRect.adjusted(-margin, -margin, margin, margin) & bounds;
+        const QList<Result> resolved =
+            clipRect.isEmpty() ? QList<Result>()
+                               : ReadBarcodes(image.cropped(clipRect.x(), clipRect.y(), clipRect.width(),
+                                                            clipRect.height()),
+                                              readerOptions);
+        if (resolved.isEmpty()) {
+            return mergeResults(ReadBarcodes(image, readerOptions), results);
+        }
+        results += resolved;
+    }
+    return results;
+}
+
+#ifdef WITH_PDF
+// Pages are scanned at a resolution that is cheap to render and decode, only
+// the regions of symbols that were located there but could not be decoded
+// are rendered again, at a resolution that scales them to about
+// PdfSymbolEdge pixels.
+static const qreal PdfScanDpi = 100;
+static const qreal PdfMaxDpi = 600;
+static const int PdfSymbolEdge = 800;
+
+static QList<Result> decodePdfPage(const PdfRasterizer &pdf, int page, const QImage &image,
+                                   const ReaderOptions &options) {
+    QList<Result> results;
+    QList<QRect> candidates;
+    for (const Result &result : ReadBarcodes(image, ReaderOptions(options).setReturnErrors(true))) {
+        if (result.isValid()) {
+            results.append(result);
+        } else {
+            candidates.append(boundingRect(result.position()));
+        }
+    }
+
+    const qreal pointsPerPixel = 72 / PdfScanDpi;
+    for (const QRect &candidate : candidates) {
+        int margin = qMax(candidate.width(), candidate.height()) / 4 + 2;
+        QRect region = candidate.adjusted(-margin, -margin, margin, margin);
+        qreal dpi = qBound(PdfScanDpi * 2, PdfScanDpi * PdfSymbolEdge / qMax(1, qMax(region.width(), region.height())),
+                           PdfMaxDpi);
+        QRectF clip(QPointF(region.topLeft()) * pointsPerPixel, QSizeF(region.size()) * pointsPerPixel);
+        results += ReadBarcodes(pdf.render(page, dpi, clip), options);
+    }
+    return results;
+}
+
+QList<PageResult> ImageDecoder::decodePdf(const ImageSource &source) const {
+    QSharedPointer<PdfRasterizer> pdf(new PdfRasterizer(source));
+    if (pdf->pageCount() <= 0) {
+        qWarning() << "failed to load PDF" << (source.filePath.isEmpty() ? source.name : source.filePath);
+        return {};
+    }
+
+    // Rendering is serialized by PDFium, the next page is rendered while
+    // the previous ones are decoded.
+    QList<PageResult> pages;
+    QList<QPair<int, QFuture<QList<Result>>>> inFlight;
+    auto collectOldest = [&]() {
+        auto oldest = inFlight.takeFirst();
+        pages.append({oldest.first, oldest.second.result(), source.name});
+    };
+    const ReaderOptions options = readerOptions;
+    for (int page = 0; page < pdf->pageCount(); ++page) {
+        QImage image = pdf->render(page, PdfScanDpi);
+        if (inFlight.size() >= framesInFlight) {
+            collectOldest();
+        }
+        inFlight.append({page, QtConcurrent::run([pdf, page, image, options]() {
+            return decodePdfPage(*pdf, page, image, options);
+        })});
+    }
+    while (!inFlight.isEmpty()) {
+        collectOldest();
+    }
+    return pages;
+}
+#endif
+
+// Every image embedded in the message is one page of the result.
+QList<PageResult> ImageDecoder::decodeMime(const ImageSource &source) const {
+    QFile file(source.filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "failed to open" << source.filePath << ":" << file.errorString();
+        return {};
+    }
+    MimeImageScanner scanner(&file);
+
+    // The scanner stays ahead of the decoders by a few images, like the
+    // frames of a multi-page image.
+    QList<PageResult> pages;
+    QList<QPair<int, QFuture<QList<PageResult>>>> inFlight;
+    auto collectOldest = [&]() {
+        auto oldest = inFlight.takeFirst();
+        QList<Result> barcodes;
+        for (const PageResult &page : oldest.second.result()) {
+            barcodes += page.barcodes;
+        }
+        pages.append({oldest.first, barcodes, source.name});
+    };
+    DataUrlImage image;
+    for (int index = 0; scanner.next(image); ++index) {
+        if (inFlight.size() >= framesInFlight) {
+            collectOldest();
+        }
+        ImageSource embedded{QString(), image.data, image.format, source.name};
+        inFlight.append({index, QtConcurrent::run([this, embedded]() { return decodeSource(embedded); })});
+    }
+    while (!inFlight.isEmpty()) {
+        collectOldest();
+    }
+    return pages;
+}
+
+#ifdef WITH_ARCHIVE
+// Pages keep their number within the entry and are reported with the entry
+// path as source.
+QList<PageResult> ImageDecoder::decodeArchive(const ImageSource &source) const {
+    ArchiveImageReader archive(source);
+    const QString archiveName = source.name.isEmpty() ? QFileInfo(source.filePath).fileName() : source.name;
+    if (!archive.isOpen()) {
+        qWarning() << "failed to open archive" << archiveName << ":" << archive.errorString();
+        return {};
+    }
+
+    // Only a few entries are held in memory, the archive is read further
+    // as their decodes complete.
+    QList<PageResult> pages;
+    QList<QFuture<QList<PageResult>>> inFlight;
+    auto collectOldest = [&]() {
+        pages += inFlight.takeFirst().result();
+    };
+    ArchiveEntry entry;
+    while (archive.next(entry)) {
+        if (inFlight.size() >= framesInFlight) {
+            collectOldest();
+        }
+        QString name = archiveName.isEmpty() ? entry.path : archiveName + "/" + entry.path;
+        ImageSource embedded{QString(), entry.data, entry.format, name};
+        entry.data.clear();
+        inFlight.append(QtConcurrent::run([this, embedded]() { return decodeSource(embedded); }));
+    }
+    while (!inFlight.isEmpty()) {
+        collectOldest();
+    }
+    return pages;
+}
+#endif
+
+QList<PageResult> ImageDecoder::decodeSource(const ImageSource &source) const {
+    if (!source.filePath.isEmpty() && MimeImageScanner::isMimeFile(source.filePath)) {
+        return decodeMime(source);
+    }
+#ifdef WITH_ARCHIVE
+    if (!source.filePath.isEmpty() && ArchiveImageReader::isArchive(source.filePath)) {
+        return decodeArchive(source);
+    }
+#endif
+#ifdef WITH_PDF
+    if (PdfRasterizer::isPdf(source)) {
+        return decodePdf(source);
+    }
+#endif
+    if (!source.filePath.isEmpty() && MappedImage::isMappable(source.filePath)) {
+        // Anything the loader can not map (ASCII or 16 bit netpbm) is left
+        // to QImageReader.
+        MappedImage image(source.filePath);
+        if (image.isValid()) {
+            return {{0, decodeView(image.view()), source.name}};
+        }
+    }
+    SourceReader sourceReader(source);
+    QImageReader &reader = sourceReader.reader;
+    QList<PageResult> pages;
+    QList<QPair<int, QFuture<QList<Result>>>> inFlight;
+
+    auto collectOldest = [&]() {
+        auto oldest = inFlight.takeFirst();
+        pages.append({oldest.first, oldest.second.result(), source.name});
+    };
+
+    // Animated formats (GIF, WebP) advance on every read(), multi-page
+    // formats (TIFF) have to be moved to the next page explicitly.
+    const bool animated = reader.supportsAnimation();
+    const int imageCount = reader.imageCount();
+    for (int page = 0; imageCount <= 0 || page < imageCount; ++page) {
+        if (page > 0 && (animated ? !reader.canRead() : !reader.jumpToNextImage())) {
+            break;
+        }
+        // Large frames are decoded at reduced size first, JPEG does that
+        // directly through DCT scaling.
+        QSize fullSize = reader.size();
+        if (fullSize.isValid() && qMax(fullSize.width(), fullSize.height()) > scanEdge) {
+            reader.setScaledSize(fullSize.scaled(scanEdge, scanEdge, Qt::KeepAspectRatio));
+        } else {
+            reader.setScaledSize(QSize());
+            fullSize = QSize();
+        }
+        QImage frame = reader.read();
+        if (frame.isNull()) {
+            if (page == 0) {
+                qWarning() << "failed to read image:" << reader.errorString();
+            }
+            break;
+        }
+
+        // Keep only a few frames alive, the reader stays ahead of the decoders.
+        if (inFlight.size() >= framesInFlight) {
+            collectOldest();
+        }
+        inFlight.append({page, QtConcurrent::run([this, source, page, frame, fullSize]() {
+            return decodeFrame(source, page, frame, fullSize);
+        })});
+    }
+    while (!inFlight.isEmpty()) {
+        collectOldest();
+    }
+    return pages;
+}
+
+QSize ImageDecoder::sourceSize(const ImageSource &source) {
+    if (!source.filePath.isEmpty() && MappedImage::isMappable(source.filePath)) {
+        MappedImage image(source.filePath);
+        if (image.isValid()) {
+            return image.size();
+        }
+    }
+    SourceReader sourceReader(source);
+    return sourceReader.reader.size();
+}
+
+QImage ImageDecoder::readPreview(const ImageSource &source, const QSize &size) {
+    if (!source.filePath.isEmpty() && MimeImageScanner::isMimeFile(source.filePath)) {
+        // The first embedded image stands for the message.
+        QFile file(source.filePath);
+        DataUrlImage image;
+        if (!file.open(QIODevice::ReadOnly) || !MimeImageScanner(&file).next(image)) {
+            return QImage();
+        }
+        return readPreview({QString(), image.data, image.format, QString()}, size);
+    }
+#ifdef WITH_ARCHIVE
+    if (!source.filePath.isEmpty() && ArchiveImageReader::isArchive(source.filePath)) {
+        // Likewise the first image entry stands for the archive.
+        ArchiveImageReader archive(source);
+        ArchiveEntry entry;
+        if (!archive.next(entry)) {
+            return QImage();
+        }
+        return readPreview({QString(), entry.data, entry.format, QString()}, size);
+    }
+#endif
+#ifdef WITH_PDF
+    if (PdfRasterizer::isPdf(source)) {
+        PdfRasterizer pdf(source);
+        QSizeF points = pdf.pageCount() > 0 ? pdf.pagePointSize(0) : QSizeF();
+        if (points.isEmpty()) {
+            return QImage();
+        }
+        return pdf.render(0, 72 * qMin(size.width() / points.width(), size.height() / points.height()));
+    }
+#endif
+    if (!source.filePath.isEmpty() && MappedImage::isMappable(source.filePath)) {
+        // Only the scaled copy is allocated.
+        MappedImage image(source.filePath);
+        if (image.isValid()) {
+            return image.image().scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        }
+    }
+    SourceReader sourceReader(source);
+    QImageReader &reader = sourceReader.reader;
+    QSize fullSize = reader.size();
+    if (!fullSize.isValid()) {
+        return reader.read().scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    if (fullSize.width() > size.width() || fullSize.height() > size.height()) {
+        reader.setScaledSize(fullSize.scaled(size, Qt::KeepAspectRatio));
+    }
+    return reader.read();
+}
+
+QString ImageDecoder::fileDialogFilter() {
+    QStringList patterns;
+    for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+        patterns << "*." + QString::fromLatin1(format);
+    }
+    for (const QString &suffix : MimeImageScanner::suffixes() + MappedImage::suffixes()) {
+        if (!patterns.contains("*." + suffix)) {
+            patterns << "*." + suffix;
+        }
+    }
+#ifdef WITH_ARCHIVE
+    for (const QString &suffix : ArchiveImageReader::suffixes()) {
+        patterns << "*." + suffix;
+    }
+#endif
+#ifdef WITH_PDF
+    patterns << "*.pdf";
+#endif
+    return QString("Image Files (%1)").arg(patterns.join(' '));
+}
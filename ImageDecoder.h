@@ -0,0 +1,74 @@
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QSize>
+#include <QString>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+// Encoded image in a file or in memory, it may be opened several times.
+struct ImageSource {
+    QString filePath;
+    QByteArray data;
+    QByteArray format; // optional hint for in-memory data
+    QString name;      // reported as PageResult::source
+};
+
+// Barcodes found on one frame of a (possibly multi-page or animated) image.
+struct PageResult {
+    int page;
+    QList<ZXingQt::Result> barcodes;
+    QString source; // name of the decoded ImageSource
+};
+
+class ImageDecoder {
+public:
+    ImageDecoder();
+
+    const ZXingQt::ReaderOptions &options() const { return readerOptions; }
+    void setOptions(const ZXingQt::ReaderOptions &options) { readerOptions = options; }
+
+    // Upper bound of decoded frames kept in memory while a multi-frame
+    // source is being read and decoded in parallel.
+    int maxFramesInFlight() const { return framesInFlight; }
+    void setMaxFramesInFlight(int count) { framesInFlight = qMax(1, count); }
+
+    // Frames larger than this are first decoded at reduced resolution,
+    // full resolution is only read when that attempt fails.
+    int maxScanEdge() const { return scanEdge; }
+    void setMaxScanEdge(int edge) { scanEdge = edge; }
+
+    QList<ZXingQt::Result> decodeImage(const QImage &image) const;
+    QList<PageResult> decodeFile(const QString &filePath) const;
+    QList<PageResult> decodeData(const QByteArray &data, const QByteArray &format = QByteArray()) const;
+    QList<PageResult> decodeSource(const ImageSource &source) const;
+
+    // Dimensions of the first frame, read from the header only.
+    static QSize sourceSize(const ImageSource &source);
+    // First frame scaled to fit into size while it is decoded, readers
+    // that support it (JPEG) never produce the full resolution image.
+    static QImage readPreview(const ImageSource &source, const QSize &size);
+    static QString fileDialogFilter();
+
+private:
+    QList<ZXingQt::Result> decodeFrame(const ImageSource &source, int page, const QImage &frame,
+                                       const QSize &fullSize) const;
+    QList<PageResult> decodeMime(const ImageSource &source) const;
+    QList<ZXingQt::Result> decodeView(const ZXing::ImageView &image) const;
+#ifdef WITH_ARCHIVE
+    QList<PageResult> decodeArchive(const ImageSource &source) const;
+#endif
+#ifdef WITH_PDF
+    QList<PageResult> decodePdf(const ImageSource &source) const;
+#endif
+
+    ZXingQt::ReaderOptions readerOptions;
+    int framesInFlight;
+    int scanEdge;
+};
+
+#endif // IMAGEDECODER_H
@@ -0,0 +1,85 @@
+#include "IngestQueue.h"
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+IngestQueue::IngestQueue(QObject *parent)
+    : QObject(parent), maxRunning(QThreadPool::globalInstance()->maxThreadCount()),
+      completedCount(0), totalCount(0), batch(0), budgetUnits(0) {
+    setMaxPixelsInFlight(qint64(128) * 1024 * 1024);
+}
+
+IngestQueue::~IngestQueue() {
+    pending.clear();
+    for (auto *watcher : running) {
+        watcher->waitForFinished();
+    }
+}
+
+void IngestQueue::setMaxPixelsInFlight(qint64 pixels) {
+    int units = int(qBound(qint64(1), pixels / PixelUnit, qint64(INT_MAX)));
+    if (units > budgetUnits) {
+        pixelBudget.release(units - budgetUnits);
+    } else {
+        pixelBudget.acquire(budgetUnits - units);
+    }
+    budgetUnits = units;
+}
+
+void IngestQueue::enqueue(const QList<ImageSource> &sources) {
+    for (const ImageSource &source : sources) {
+        pending.enqueue(source);
+    }
+    totalCount += sources.size();
+    emit progress(completedCount, totalCount);
+    dispatch();
+}
+
+void IngestQueue::clear() {
+    pending.clear();
+    completedCount = 0;
+    totalCount = 0;
+    ++batch;
+}
+
+static QList<PageResult> decodeWithinBudget(const ImageDecoder &decoder, const ImageSource &source,
+                                            QSemaphore *pixelBudget, int budgetUnits, int pixelUnit) {
+    // Sources larger than the whole budget are decoded on their own.
+    QSize size = ImageDecoder::sourceSize(source);
+    qint64 pixels = size.isValid() ? qint64(size.width()) * size.height() : pixelUnit;
+    int units = int(qBound(qint64(1), pixels / pixelUnit, qint64(budgetUnits)));
+
+    pixelBudget->acquire(units);
+    QSemaphoreReleaser releaser(pixelBudget, units);
+    return decoder.decodeSource(source);
+}
+
+void IngestQueue::dispatch() {
+    while (!pending.isEmpty() && running.size() < maxRunning) {
+        ImageSource source = pending.dequeue();
+
+        auto *watcher = new QFutureWatcher<QList<PageResult>>(this);
+        running.insert(watcher);
+        const int currentBatch = batch;
+        const QString name = source.name;
+        connect(watcher, &QFutureWatcher<QList<PageResult>>::finished, this, [this, watcher, currentBatch, name]() {
+            running.remove(watcher);
+            watcher->deleteLater();
+            if (currentBatch == batch) {
+                ++completedCount;
+                emit sourceDecoded(name, watcher->result());
+                emit progress(completedCount, totalCount);
+            }
+            dispatch();
+            if (isIdle()) {
+                emit finished();
+            }
+        });
+        ImageDecoder decoder = this->decoder;
+        QSemaphore *budget = &pixelBudget;
+        int units = budgetUnits;
+        watcher->setFuture(QtConcurrent::run([decoder, source, budget, units]() {
+            return decodeWithinBudget(decoder, source, budget, units, PixelUnit);
+        }));
+    }
+}
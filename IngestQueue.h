@@ -0,0 +1,56 @@
+#ifndef INGESTQUEUE_H
+#define INGESTQUEUE_H
+
+#include <QObject>
+#include <QQueue>
+#include <QSemaphore>
+#include <QSet>
+
+#include "ImageDecoder.h"
+
+template <typename T> class QFutureWatcher;
+
+// Decodes a batch of image sources on the thread pool. Results are reported
+// per source as soon as it is done, the number of decoded pixels held by
+// all workers together stays below a configurable limit.
+class IngestQueue : public QObject {
+    Q_OBJECT
+
+public:
+    explicit IngestQueue(QObject *parent = nullptr);
+    ~IngestQueue();
+
+    void setDecoder(const ImageDecoder &decoder) { this->decoder = decoder; }
+    // Only to be changed while the queue is idle.
+    void setMaxPixelsInFlight(qint64 pixels);
+
+    void enqueue(const QList<ImageSource> &sources);
+    // Drops pending sources, results of sources still being decoded are
+    // discarded.
+    void clear();
+
+    bool isIdle() const { return pending.isEmpty() && running.isEmpty(); }
+
+signals:
+    void sourceDecoded(const QString &name, const QList<PageResult> &pages);
+    void progress(int completed, int total);
+    void finished();
+
+private:
+    void dispatch();
+
+    ImageDecoder decoder;
+    QQueue<ImageSource> pending;
+    QSet<QFutureWatcher<QList<PageResult>> *> running;
+    int maxRunning;
+    int completedCount;
+    int totalCount;
+    int batch;
+
+    // One unit of the budget is PixelUnit decoded pixels.
+    static const int PixelUnit = 65536;
+    int budgetUnits;
+    QSemaphore pixelBudget;
+};
+
+#endif // INGESTQUEUE_H
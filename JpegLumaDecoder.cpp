@@ -0,0 +1,104 @@
+#include "JpegLumaDecoder.h"
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+namespace {
+
+struct ErrorManager {
+    jpeg_error_mgr base;
+    jmp_buf jump;
+};
+
+void errorExit(j_common_ptr info) {
+    longjmp(reinterpret_cast<ErrorManager *>(info->err)->jump, 1);
+}
+
+// Truncated and slightly corrupt frames are common with MJPEG cameras, the
+// warnings for them are not worth a line per frame.
+void ignoreMessage(j_common_ptr, int) {
+}
+
+} // namespace
+
+JpegLumaDecoder::JpegLumaDecoder(FrameBufferPool *pool, int minEdge)
+    : pool(pool), minEdge(minEdge), width(0), height(0), denominator(1) {
+}
+
+#ifdef QT_MULTIMEDIA_LIB
+bool JpegLumaDecoder::isJpeg(const QVideoFrame &frame) {
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    return frame.pixelFormat() == QVideoFrame::Format_Jpeg;
+#else
+    return frame.pixelFormat() == QVideoFrameFormat::Format_Jpeg;
+#endif
+}
+
+bool JpegLumaDecoder::decode(const QVideoFrame &frame) {
+    auto img = frame; // shallow copy just get access to non-const map() function
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    if (!isJpeg(img) || !img.map(QAbstractVideoBuffer::ReadOnly)) {
+        return false;
+    }
+    bool decoded = decode(img.bits(), size_t(img.mappedBytes()));
+#else
+    if (!isJpeg(img) || !img.map(QVideoFrame::ReadOnly)) {
+        return false;
+    }
+    bool decoded = decode(img.bits(0), size_t(img.mappedBytes(0)));
+#endif
+    img.unmap();
+    return decoded;
+}
+#endif
+
+bool JpegLumaDecoder::decode(const uchar *data, size_t size) {
+    jpeg_decompress_struct info;
+    ErrorManager error;
+    info.err = jpeg_std_error(&error.base);
+    error.base.error_exit = errorExit;
+    error.base.emit_message = ignoreMessage;
+    if (setjmp(error.jump)) {
+        jpeg_destroy_decompress(&info);
+        width = height = 0;
+        return false;
+    }
+
+    jpeg_create_decompress(&info);
+    jpeg_mem_src(&info, const_cast<uchar *>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&info, TRUE);
+
+    // Grayscale output skips chroma upsampling and colour conversion, the
+    // chroma components are not even dequantized.
+    info.out_color_space = JCS_GRAYSCALE;
+    info.dct_method = JDCT_IFAST;
+    denominator = 1;
+    while (denominator < 8 && qMin(info.image_width, info.image_height) / (denominator * 2) >= unsigned(minEdge)) {
+        denominator *= 2;
+    }
+    info.scale_num = 1;
+    info.scale_denom = unsigned(denominator);
+
+    jpeg_start_decompress(&info);
+    width = int(info.output_width);
+    height = int(info.output_height);
+    // The previous frame's buffer goes back to the pool, in steady state
+    // two buffers of the same size alternate.
+    buffer = pool->acquire(width * height);
+    uchar *pixels = buffer.data();
+    while (info.output_scanline < info.output_height) {
+        JSAMPROW rows[16];
+        int count = qMin(16, int(info.output_height - info.output_scanline));
+        for (int i = 0; i < count; ++i) {
+            rows[i] = pixels + (int(info.output_scanline) + i) * width;
+        }
+        jpeg_read_scanlines(&info, rows, JDIMENSION(count));
+    }
+    jpeg_finish_decompress(&info);
+    jpeg_destroy_decompress(&info);
+    return true;
+}
+
+ZXing::ImageView JpegLumaDecoder::image() const {
+    return ZXing::ImageView(buffer.data(), width, height, ZXing::ImageFormat::Lum);
+}
@@ -0,0 +1,40 @@
+#ifndef JPEGLUMADECODER_H
+#define JPEGLUMADECODER_H
+
+#include <cstddef>
+
+#include "FrameBufferPool.h"
+#include "ZXingQt/ZXingQtReader.h"
+
+// Decodes only the luma of compressed (MJPEG) camera frames with libjpeg,
+// letting the IDCT scale large frames down, into a buffer leased from the
+// pool of the decode pipeline. Much cheaper than the full colour conversion of
+// QVideoFrame::toImage(). One decoder per camera, it must not be used
+// concurrently.
+class JpegLumaDecoder {
+public:
+    // Frames are scaled down by up to 1/8 as long as the shorter edge stays
+    // at or above minEdge.
+    explicit JpegLumaDecoder(FrameBufferPool *pool, int minEdge = 480);
+
+#ifdef QT_MULTIMEDIA_LIB
+    static bool isJpeg(const QVideoFrame &frame);
+    bool decode(const QVideoFrame &frame);
+#endif
+    bool decode(const uchar *data, size_t size);
+
+    // Valid until the next decode. Positions of barcodes found in it are in
+    // scaled coordinates.
+    ZXing::ImageView image() const;
+    int scaleDenominator() const { return denominator; }
+
+private:
+    FrameBufferPool *pool;
+    FrameBufferPool::Lease buffer;
+    int minEdge;
+    int width;
+    int height;
+    int denominator;
+};
+
+#endif // JPEGLUMADECODER_H
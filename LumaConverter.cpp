@@ -0,0 +1,73 @@
+#include "LumaConverter.h"
+#include <cstring>
+
+// Same weights as qGray().
+static inline uchar gray(int r, int g, int b) {
+    return uchar((r * 11 + g * 16 + b * 5) / 32);
+}
+
+LumaConverter::LumaConverter(FrameBufferPool *pool) : pool(pool), width(0), height(0) {
+}
+
+#ifdef QT_MULTIMEDIA_LIB
+bool LumaConverter::convert(const QVideoFrame &frame) {
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    return convert(frame.image());
+#else
+    return convert(frame.toImage());
+#endif
+}
+#endif
+
+bool LumaConverter::convert(const QImage &image) {
+    if (image.isNull()) {
+        width = height = 0;
+        return false;
+    }
+    width = image.width();
+    height = image.height();
+    // The previous frame's buffer goes back to the pool, in steady state
+    // two buffers of the same size alternate.
+    buffer = pool->acquire(width * height);
+    for (int y = 0; y < height; ++y) {
+        const uchar *in = image.constScanLine(y);
+        uchar *out = buffer.data() + y * width;
+        switch (image.format()) {
+        case QImage::Format_Grayscale8:
+            memcpy(out, in, size_t(width));
+            break;
+        case QImage::Format_RGB32:
+        case QImage::Format_ARGB32:
+        case QImage::Format_ARGB32_Premultiplied:
+            for (int x = 0; x < width; ++x) {
+                const QRgb pixel = reinterpret_cast<const QRgb *>(in)[x];
+                out[x] = gray(qRed(pixel), qGreen(pixel), qBlue(pixel));
+            }
+            break;
+        case QImage::Format_RGBX8888:
+        case QImage::Format_RGBA8888:
+        case QImage::Format_RGBA8888_Premultiplied:
+            for (int x = 0; x < width; ++x) {
+                out[x] = gray(in[4 * x], in[4 * x + 1], in[4 * x + 2]);
+            }
+            break;
+        case QImage::Format_RGB888:
+            for (int x = 0; x < width; ++x) {
+                out[x] = gray(in[3 * x], in[3 * x + 1], in[3 * x + 2]);
+            }
+            break;
+        default:
+            // Rare formats go pixel by pixel rather than through a
+            // converted copy.
+            for (int x = 0; x < width; ++x) {
+                out[x] = uchar(qGray(image.pixel(x, y)));
+            }
+            break;
+        }
+    }
+    return true;
+}
+
+ZXing::ImageView LumaConverter::image() const {
+    return ZXing::ImageView(buffer.data(), width, height, ZXing::ImageFormat::Lum);
+}
@@ -0,0 +1,33 @@
+#ifndef LUMACONVERTER_H
+#define LUMACONVERTER_H
+
+#include <QImage>
+
+#include "FrameBufferPool.h"
+#include "ZXingQt/ZXingQtReader.h"
+
+// Converts camera frames zxing can not read directly to a luma plane in a
+// buffer leased from the pool of the decode pipeline, instead of the
+// grayscale QImage ZXingQt::ReadBarcodes() would allocate for every frame.
+// The colour image Qt converts such a frame to first is still allocated by
+// Qt. One converter per camera, it must not be used concurrently.
+class LumaConverter {
+public:
+    explicit LumaConverter(FrameBufferPool *pool);
+
+#ifdef QT_MULTIMEDIA_LIB
+    bool convert(const QVideoFrame &frame);
+#endif
+    bool convert(const QImage &image);
+
+    // Valid until the next conversion.
+    ZXing::ImageView image() const;
+
+private:
+    FrameBufferPool *pool;
+    FrameBufferPool::Lease buffer;
+    int width;
+    int height;
+};
+
+#endif // LUMACONVERTER_H
@@ -0,0 +1,116 @@
+#include "LumaPyramid.h"
+#include <QPolygon>
+#include <QtMath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Shorter edge below which a level is not built, and the edge a symbol
+// should still have at the level it is decoded on (about 4 pixels per
+// module for a version 6 QR code).
+static const int MinLevelEdge = 240;
+static const int MinSymbolEdge = 160;
+// Without recent detections frames are first decoded at a level with about
+// this shorter edge.
+static const int DefaultEdge = 540;
+static const int MaxMisses = 30;
+
+LumaPyramid::LumaPyramid(FrameBufferPool *pool)
+    : pool(pool), base(nullptr), widths{}, heights{}, levels(1), built(1),
+      decodedLevel(-1), symbolEdge(0), misses(0) {
+}
+
+void LumaPyramid::reset(const ZXing::ImageView *image) {
+    base = image;
+    widths[0] = image->width();
+    heights[0] = image->height();
+    built = 1;
+    levels = 1;
+    while (levels < MaxLevels && qMin(widths[0], heights[0]) >> levels >= MinLevelEdge) {
+        ++levels;
+    }
+}
+
+int LumaPyramid::startLevel() const {
+    int level = 0;
+    if (symbolEdge > 0) {
+        while (level + 1 < levels && symbolEdge >> (level + 1) >= MinSymbolEdge) {
+            ++level;
+        }
+    } else {
+        const int edge = qMin(widths[0], heights[0]);
+        while (level + 1 < levels && edge >> (level + 1) >= DefaultEdge) {
+            ++level;
+        }
+    }
+    return level;
+}
+
+// Halves src (any ZXing format, sampled on the green channel) into dst.
+static void halve(const ZXing::ImageView &src, uchar *dst, int width, int height) {
+    const int pixStride = src.pixStride();
+    const int channel = ZXing::GreenIndex(src.format());
+    for (int y = 0; y < height; ++y) {
+        const uint8_t *r0 = src.data(0, 2 * y) + channel;
+        const uint8_t *r1 = src.data(0, 2 * y + 1) + channel;
+        uchar *out = dst + y * width;
+        int x = 0;
+#ifdef __SSE2__
+        if (pixStride == 1) {
+            // 32 source columns of two rows into 16 outputs: average the
+            // rows, then neighbouring columns as 16 bit lanes.
+            const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+            for (; x + 16 <= width; x += 16) {
+                __m128i a = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(r0 + 2 * x)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(r1 + 2 * x)));
+                __m128i b = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(r0 + 2 * x + 16)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(r1 + 2 * x + 16)));
+                a = _mm_avg_epu16(_mm_and_si128(a, lowBytes), _mm_srli_epi16(a, 8));
+                b = _mm_avg_epu16(_mm_and_si128(b, lowBytes), _mm_srli_epi16(b, 8));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(a, b));
+            }
+        }
+#endif
+        for (; x < width; ++x) {
+            const int left = 2 * x * pixStride;
+            const int right = left + pixStride;
+            out[x] = uchar((r0[left] + r0[right] + r1[left] + r1[right] + 2) / 4);
+        }
+    }
+}
+
+ZXing::ImageView LumaPyramid::level(int level) {
+    if (level == 0) {
+        return *base;
+    }
+    while (built <= level) {
+        const ZXing::ImageView source = this->level(built - 1);
+        widths[built] = widths[built - 1] / 2;
+        heights[built] = heights[built - 1] / 2;
+        // Returned first, so the buffer of the previous frame is reused.
+        leases[built] = FrameBufferPool::Lease();
+        leases[built] = pool->acquire(widths[built] * heights[built]);
+        halve(source, leases[built].data(), widths[built], heights[built]);
+        ++built;
+    }
+    return ZXing::ImageView(leases[level].data(), widths[level], heights[level], ZXing::ImageFormat::Lum);
+}
+
+void LumaPyramid::detected(const QList<ZXingQt::Result> &results, int level) {
+    decodedLevel = level;
+    misses = 0;
+    symbolEdge = 0;
+    for (const ZXingQt::Result &result : results) {
+        QRect bounds = QPolygon({result.position().topLeft(), result.position().topRight(),
+                                 result.position().bottomRight(), result.position().bottomLeft()})
+                           .boundingRect();
+        symbolEdge = qMax(symbolEdge, qMin(bounds.width(), bounds.height()) << level);
+    }
+}
+
+void LumaPyramid::missed() {
+    decodedLevel = -1;
+    if (++misses > MaxMisses) {
+        symbolEdge = 0;
+    }
+}
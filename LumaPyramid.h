@@ -0,0 +1,61 @@
+#ifndef LUMAPYRAMID_H
+#define LUMAPYRAMID_H
+
+#include <QList>
+
+#include "FrameBufferPool.h"
+#include "ZXingQt/ZXingQtReader.h"
+
+// Successively halved luma planes of a camera frame (2x2 box filter) to
+// decode large, close symbols at a fraction of the pixels. Decoding starts
+// at the coarsest level the size of recent detections suggests and only
+// moves to finer levels if nothing is found. Levels are built on demand
+// into buffers of the frame pool. One pyramid per camera, it must not be
+// used concurrently.
+class LumaPyramid {
+public:
+    explicit LumaPyramid(FrameBufferPool *pool);
+
+    // decodeLevel is called with the image view of a level and returns the
+    // results found on it. Positions are in the coordinates of that level.
+    template <typename DecodeLevel>
+    QList<ZXingQt::Result> decode(const ZXing::ImageView &image, DecodeLevel &&decodeLevel) {
+        reset(&image);
+        for (int level = startLevel(); level >= 0; --level) {
+            QList<ZXingQt::Result> results = decodeLevel(this->level(level));
+            if (!results.isEmpty()) {
+                detected(results, level);
+                return results;
+            }
+        }
+        missed();
+        return {};
+    }
+
+    int lastLevel() const { return decodedLevel; }
+
+private:
+    static const int MaxLevels = 4;
+
+    void reset(const ZXing::ImageView *image);
+    int startLevel() const;
+    ZXing::ImageView level(int level);
+    void detected(const QList<ZXingQt::Result> &results, int level);
+    void missed();
+
+    FrameBufferPool *pool;
+    const ZXing::ImageView *base; // the frame being decoded
+    FrameBufferPool::Lease leases[MaxLevels];
+    int widths[MaxLevels];
+    int heights[MaxLevels];
+    int levels; // levels worth building for the current frame
+    int built;  // levels built for the current frame
+    int decodedLevel;
+
+    // Edge of the last detected symbol in full resolution pixels, forgotten
+    // after a number of frames without any detection.
+    int symbolEdge;
+    int misses;
+};
+
+#endif // LUMAPYRAMID_H
@@ -0,0 +1,112 @@
+#include "MappedImage.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <cctype>
+#include <climits>
+
+static const QStringList NetpbmSuffixes = {"pgm", "ppm", "pnm"};
+static const QStringList RawSuffixes = {"gray", "gray8", "y8"};
+
+MappedImage::MappedImage(const QString &filePath)
+    : file(filePath), pixels(nullptr), width(0), height(0), rowStride(0), format(ZXing::ImageFormat::None) {
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "failed to open" << filePath << ":" << file.errorString();
+        return;
+    }
+    const qint64 length = file.size();
+    const uchar *data = length > 0 ? file.map(0, length) : nullptr;
+    if (!data) {
+        return;
+    }
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    const qint64 offset = NetpbmSuffixes.contains(suffix) ? parseNetpbm(data, length) : parseRaw(length);
+    if (offset >= 0) {
+        pixels = data + offset;
+    } else {
+        file.unmap(const_cast<uchar *>(data));
+    }
+}
+
+QStringList MappedImage::suffixes() {
+    return NetpbmSuffixes + RawSuffixes;
+}
+
+bool MappedImage::isMappable(const QString &filePath) {
+    return suffixes().contains(QFileInfo(filePath).suffix().toLower());
+}
+
+// Reads the header of a binary PGM (P5) or PPM (P6).
+qint64 MappedImage::parseNetpbm(const uchar *data, qint64 length) {
+    if (length < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) {
+        return -1;
+    }
+    qint64 pos = 2;
+    auto readNumber = [&](int &value) {
+        // Whitespace and comments may appear anywhere between the fields.
+        while (pos < length && (isspace(data[pos]) || data[pos] == '#')) {
+            if (data[pos] == '#') {
+                while (pos < length && data[pos] != '\n') {
+                    ++pos;
+                }
+            } else {
+                ++pos;
+            }
+        }
+        qint64 start = pos;
+        qint64 number = 0;
+        while (pos < length && isdigit(data[pos]) && number <= INT_MAX) {
+            number = number * 10 + (data[pos++] - '0');
+        }
+        value = int(number);
+        return pos > start && number > 0 && number <= INT_MAX;
+    };
+    int maxValue = 0;
+    if (!readNumber(width) || !readNumber(height) || !readNumber(maxValue) || pos >= length || !isspace(data[pos])) {
+        return -1;
+    }
+    // 16 bit samples are left to QImageReader.
+    if (maxValue > 255) {
+        return -1;
+    }
+    ++pos;
+    const int channels = data[1] == '5' ? 1 : 3;
+    format = channels == 1 ? ZXing::ImageFormat::Lum : ZXing::ImageFormat::RGB;
+    // Checked in 64 bit, width * 3 overflows int for huge PPM headers.
+    const qint64 stride = qint64(width) * channels;
+    if (stride > INT_MAX || stride > (length - pos) / height) {
+        qWarning() << "truncated or oversized image" << file.fileName();
+        return -1;
+    }
+    rowStride = int(stride);
+    return pos;
+}
+
+// Raw dumps are width x height gray bytes, the size is taken from the last
+// "<width>x<height>" in the file name.
+qint64 MappedImage::parseRaw(qint64 length) {
+    static const QRegularExpression sizePattern("(\\d+)x(\\d+)");
+    QRegularExpressionMatchIterator it = sizePattern.globalMatch(QFileInfo(file.fileName()).completeBaseName());
+    QRegularExpressionMatch match;
+    while (it.hasNext()) {
+        match = it.next();
+    }
+    width = match.captured(1).toInt();
+    height = match.captured(2).toInt();
+    if (width <= 0 || height <= 0 || length % height != 0 || length / height < width || length / height > INT_MAX) {
+        qWarning() << "raw image" << file.fileName() << "needs its size as <width>x<height> in the name";
+        return -1;
+    }
+    rowStride = int(length / height);
+    format = ZXing::ImageFormat::Lum;
+    return 0;
+}
+
+ZXing::ImageView MappedImage::view() const {
+    return ZXing::ImageView(pixels, width, height, format, rowStride);
+}
+
+QImage MappedImage::image() const {
+    return QImage(pixels, width, height, rowStride,
+                  format == ZXing::ImageFormat::Lum ? QImage::Format_Grayscale8 : QImage::Format_RGB888);
+}
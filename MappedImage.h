@@ -0,0 +1,46 @@
+#ifndef MAPPEDIMAGE_H
+#define MAPPEDIMAGE_H
+
+#include <QFile>
+#include <QImage>
+#include <QSize>
+#include <QStringList>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+// Binary PGM/PPM files (up to 8 bit per sample) and raw 8 bit gray dumps
+// mapped into memory, their pixels are handed to ZXing where they are
+// without a QImage in between (zxing still makes a luma copy of PPM's RGB).
+// Raw dumps carry their size in the file name, e.g. "scan_4096x3072.gray";
+// rows may be padded as long as the file size is a multiple of the height.
+class MappedImage {
+public:
+    explicit MappedImage(const QString &filePath);
+
+    // File extensions the loader is meant for, e.g. to route files to it.
+    static QStringList suffixes();
+    static bool isMappable(const QString &filePath);
+
+    // False if the file could not be mapped or is not in a mappable
+    // variant of its format (e.g. ASCII or 16 bit PGM).
+    bool isValid() const { return pixels != nullptr; }
+    QSize size() const { return QSize(width, height); }
+
+    // Both stay valid as long as this object.
+    ZXing::ImageView view() const;
+    QImage image() const;
+
+private:
+    // Offset of the raster in the file, -1 if it can not be mapped.
+    qint64 parseNetpbm(const uchar *data, qint64 length);
+    qint64 parseRaw(qint64 length);
+
+    QFile file;
+    const uchar *pixels;
+    int width;
+    int height;
+    int rowStride;
+    ZXing::ImageFormat format;
+};
+
+#endif // MAPPEDIMAGE_H
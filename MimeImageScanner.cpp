@@ -0,0 +1,157 @@
+#include "MimeImageScanner.h"
+#include <QFileInfo>
+#include <QRegularExpression>
+
+// Longest piece read at once, longer lines are handled in pieces.
+static const qint64 MaxLine = 64 * 1024;
+
+MimeImageScanner::MimeImageScanner(QIODevice *device)
+    : device(device), mbox(false), atLineStart(true), state(Headers), attachment(false) {
+    mbox = device->peek(5) == "From ";
+}
+
+QStringList MimeImageScanner::suffixes() {
+    return {"eml", "mht", "mhtml", "mbox", "mbx"};
+}
+
+bool MimeImageScanner::isMimeFile(const QString &filePath) {
+    return suffixes().contains(QFileInfo(filePath).suffix().toLower());
+}
+
+void MimeImageScanner::startPart() {
+    state = Headers;
+    headers.clear();
+}
+
+// Value of a header (unfolded) and the named parameter of it.
+static QByteArray headerValue(const QByteArray &headers, const QByteArray &name) {
+    QRegularExpression pattern("^" + QRegularExpression::escape(QString::fromLatin1(name)) + ":\\s*(.*)$",
+                               QRegularExpression::CaseInsensitiveOption | QRegularExpression::MultilineOption);
+    return pattern.match(QString::fromLatin1(headers)).captured(1).trimmed().toLatin1();
+}
+
+static QByteArray parameter(const QByteArray &value, const QByteArray &name) {
+    QRegularExpression pattern(";\\s*" + QString::fromLatin1(name) + "\\s*=\\s*(\"([^\"]*)\"|[^;\\s]+)",
+                               QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = pattern.match(QString::fromLatin1(value));
+    if (!match.hasMatch()) {
+        return QByteArray();
+    }
+    return (match.capturedLength(2) > 0 ? match.captured(2) : match.captured(1)).toLatin1();
+}
+
+void MimeImageScanner::parseHeaders() {
+    // Folded header lines continue with whitespace.
+    QByteArray unfolded = headers;
+    unfolded.replace("\r\n", "\n").replace("\n ", " ").replace("\n\t", " ");
+
+    const QByteArray contentType = headerValue(unfolded, "Content-Type");
+    const QByteArray mimeType = contentType.split(';').value(0).trimmed().toLower();
+    const bool base64 = headerValue(unfolded, "Content-Transfer-Encoding").toLower() == "base64";
+
+    if (mimeType.startsWith("multipart/")) {
+        QByteArray boundary = parameter(contentType, "boundary");
+        if (!boundary.isEmpty()) {
+            boundaries.append("--" + boundary);
+            state = Preamble;
+            return;
+        }
+    }
+    attachment = mimeType == "application/octet-stream";
+    if (base64 && (mimeType.startsWith("image/") || attachment)) {
+        decoder = Base64Decoder();
+        data.clear();
+        state = ImageBody;
+    } else {
+        state = SkipBody;
+    }
+}
+
+bool MimeImageScanner::finishPart(DataUrlImage &image) {
+    if (state != ImageBody) {
+        return false;
+    }
+    decoder.finish(data);
+    state = SkipBody;
+    image.format = DataUrlScanner::sniffFormat(data);
+    if (data.isEmpty() || (attachment && image.format.isEmpty())) {
+        data.clear();
+        return false;
+    }
+    image.data = data;
+    data.clear();
+    return true;
+}
+
+int MimeImageScanner::matchBoundary(const QByteArray &line, bool &closing) const {
+    if (!line.startsWith("--")) {
+        return -1;
+    }
+    const QByteArray trimmed = line.trimmed();
+    for (int i = boundaries.size() - 1; i >= 0; --i) {
+        if (trimmed == boundaries[i] || trimmed == boundaries[i] + "--") {
+            closing = trimmed.size() > boundaries[i].size();
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool MimeImageScanner::next(DataUrlImage &image) {
+    while (!device->atEnd()) {
+        const QByteArray line = device->readLine(MaxLine);
+        const bool lineStart = atLineStart;
+        atLineStart = line.endsWith('\n');
+        if (line.isEmpty()) {
+            break;
+        }
+
+        if (lineStart && mbox && line.startsWith("From ") && state != Headers) {
+            // Next message of the mailbox.
+            bool found = finishPart(image);
+            boundaries.clear();
+            startPart();
+            if (found) {
+                return true;
+            }
+            continue;
+        }
+
+        bool closing = false;
+        const int boundary = lineStart && state != Headers ? matchBoundary(line, closing) : -1;
+        if (boundary >= 0) {
+            bool found = finishPart(image);
+            // Nested multiparts that were not closed properly end with
+            // their parent.
+            boundaries.erase(boundaries.begin() + boundary + 1, boundaries.end());
+            if (closing) {
+                boundaries.removeLast();
+                state = Preamble; // epilogue of this multipart
+            } else {
+                startPart();
+            }
+            if (found) {
+                return true;
+            }
+            continue;
+        }
+
+        switch (state) {
+        case Headers:
+            if (line.trimmed().isEmpty()) {
+                parseHeaders();
+            } else if (!(mbox && line.startsWith("From ") && headers.isEmpty())) {
+                headers += line;
+            }
+            break;
+        case ImageBody:
+            decoder.feed(line.constData(), line.constData() + line.size(), data);
+            break;
+        case Preamble:
+        case SkipBody:
+            break;
+        }
+    }
+    // A part cut off by the end of the input still counts.
+    return finishPart(image);
+}
@@ -0,0 +1,49 @@
+#ifndef MIMEIMAGESCANNER_H
+#define MIMEIMAGESCANNER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QList>
+#include <QStringList>
+
+#include "Base64Decoder.h"
+#include "DataUrlScanner.h"
+
+// Streaming parser for e-mail (.eml), MHTML and mbox files that yields the
+// base64 encoded images of their MIME parts, including nested multiparts
+// and application/octet-stream attachments that turn out to be images. The
+// message is read line by line, only the image being decoded is held in
+// memory.
+class MimeImageScanner {
+public:
+    explicit MimeImageScanner(QIODevice *device);
+
+    // File extensions the scanner is meant for, e.g. to route files to it.
+    static QStringList suffixes();
+    static bool isMimeFile(const QString &filePath);
+
+    // Reads up to the end of the next image part. Returns false at the end
+    // of the input.
+    bool next(DataUrlImage &image);
+
+private:
+    enum State { Headers, Preamble, ImageBody, SkipBody };
+
+    void startPart();
+    void parseHeaders();
+    bool finishPart(DataUrlImage &image);
+    // Index into boundaries of the boundary the line delimits, -1 if none.
+    int matchBoundary(const QByteArray &line, bool &closing) const;
+
+    QIODevice *device;
+    bool mbox;
+    bool atLineStart;
+    State state;
+    QList<QByteArray> boundaries;
+    QByteArray headers;
+    bool attachment; // application/octet-stream, kept only if it sniffs as an image
+    Base64Decoder decoder;
+    QByteArray data;
+};
+
+#endif // MIMEIMAGESCANNER_H
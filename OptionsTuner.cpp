@@ -0,0 +1,219 @@
+#include "OptionsTuner.h"
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QImageReader>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent>
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+using namespace ZXingQt;
+
+OptionsTuner::OptionsTuner(const ReaderOptions &base) : base(base) {
+}
+
+int OptionsTuner::loadCorpus(const QString &directory) {
+    QSet<QByteArray> formats;
+    for (const QByteArray &format : QImageReader::supportedImageFormats()) {
+        formats.insert(format.toLower());
+    }
+    QDirIterator it(directory, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (!formats.contains(QFileInfo(path).suffix().toLower().toLatin1())) {
+            continue;
+        }
+        if (QImageReader(path).canRead()) {
+            imagePaths.append(path);
+        }
+    }
+    return imagePaths.size();
+}
+
+QList<ReaderOptions> OptionsTuner::settings() const {
+    QList<ReaderOptions> all;
+    const Binarizer binarizers[] = {Binarizer::LocalAverage, Binarizer::GlobalHistogram, Binarizer::FixedThreshold,
+                                    Binarizer::BoolCast};
+    for (int flags = 0; flags < 32; ++flags) {
+        for (Binarizer binarizer : binarizers) {
+            for (int maxSymbols : {1, 10}) {
+                all.append(ReaderOptions(base)
+                               .setTryHarder(flags & 1)
+                               .setTryRotate(flags & 2)
+                               .setTryInvert(flags & 4)
+                               .setTryDownscale(flags & 8)
+                               .setIsPure(flags & 16)
+                               .setBinarizer(binarizer)
+                               .setMaxNumberOfSymbols(maxSymbols));
+            }
+        }
+    }
+    return all;
+}
+
+// Resident set size in KiB from /proc/self/status, -1 where there is none.
+static qint64 statusKiB(const QByteArray &key) {
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    for (const QByteArray &line : status.readAll().split('\n')) {
+        if (line.startsWith(key + ":")) {
+            return line.mid(key.size() + 1).trimmed().split(' ').value(0).toLongLong();
+        }
+    }
+    return -1;
+}
+
+// Lets VmHWM start again from the current resident size (Linux 4.0+).
+static bool resetPeakRss() {
+    QFile clearRefs("/proc/self/clear_refs");
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+}
+
+static bool sameSettings(const ReaderOptions &a, const ReaderOptions &b) {
+    return a.tryHarder() == b.tryHarder() && a.tryRotate() == b.tryRotate() && a.tryInvert() == b.tryInvert() &&
+           a.tryDownscale() == b.tryDownscale() && a.isPure() == b.isPure() && a.binarizer() == b.binarizer() &&
+           a.maxNumberOfSymbols() == b.maxNumberOfSymbols();
+}
+
+QList<OptionsTuner::Measurement> OptionsTuner::run() {
+    struct Decoded {
+        QSet<QString> texts;
+        double msecs;
+    };
+
+    const QList<ReaderOptions> all = settings();
+    // Images are loaded a batch of one per worker at a time, outside of the
+    // peak memory window, so only what ReadBarcodes allocates is measured.
+    const int batchSize = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+
+    // Found texts per setting and image, the union over all settings is
+    // the reference the hit rate is measured against.
+    QList<QList<QSet<QString>>> found;
+    QList<Measurement> measurements;
+    QVector<QSet<QString>> reference(imagePaths.size());
+    for (const ReaderOptions &options : all) {
+        std::function<QImage(const QString &)> load = [](const QString &path) { return QImage(path); };
+        std::function<Decoded(const QImage &)> decode = [&options](const QImage &image) {
+            QElapsedTimer timer;
+            timer.start();
+            QList<Result> results = ReadBarcodes(image, options);
+            Decoded decoded{QSet<QString>(), timer.nsecsElapsed() / 1e6};
+            for (const Result &result : results) {
+                if (result.isValid()) {
+                    decoded.texts.insert(result.text());
+                }
+            }
+            return decoded;
+        };
+        QList<Decoded> decoded;
+        qint64 peak = 0;
+        for (int first = 0; first < imagePaths.size(); first += batchSize) {
+            const QList<QImage> images =
+                QtConcurrent::blockingMapped<QList<QImage>>(imagePaths.mid(first, batchSize), load);
+            const bool peakReset = resetPeakRss();
+            const qint64 baseline = statusKiB("VmRSS");
+            decoded += QtConcurrent::blockingMapped<QList<Decoded>>(images, decode);
+            const qint64 batchPeak = statusKiB("VmHWM");
+            if (peak >= 0 && peakReset && baseline >= 0 && batchPeak >= 0) {
+                peak = qMax(peak, batchPeak - baseline);
+            } else {
+                peak = -1;
+            }
+        }
+
+        QVector<double> msecs;
+        QList<QSet<QString>> texts;
+        for (int i = 0; i < decoded.size(); ++i) {
+            msecs.append(decoded[i].msecs);
+            texts.append(decoded[i].texts);
+            reference[i] += decoded[i].texts;
+        }
+        std::sort(msecs.begin(), msecs.end());
+        Measurement measurement{options, 0, 0, 0, -1, false, sameSettings(options, base)};
+        if (!msecs.isEmpty()) {
+            measurement.meanMsecs = std::accumulate(msecs.begin(), msecs.end(), 0.0) / msecs.size();
+            measurement.p95Msecs = msecs[qMin(msecs.size() - 1, int(msecs.size() * 0.95))];
+        }
+        if (!decoded.isEmpty()) {
+            measurement.peakKiB = peak;
+        }
+        measurements.append(measurement);
+        found.append(texts);
+    }
+
+    int referenceCount = 0;
+    for (const QSet<QString> &texts : reference) {
+        referenceCount += texts.size();
+    }
+    for (int s = 0; s < measurements.size(); ++s) {
+        int hits = 0;
+        for (const QSet<QString> &texts : found[s]) {
+            hits += texts.size();
+        }
+        measurements[s].hitRate = referenceCount > 0 ? double(hits) / referenceCount : 0;
+    }
+
+    // Pareto optimal: no other setting has at least the hit rate at no more
+    // mean and p95 latency and peak memory while being strictly better in
+    // one of them. Memory is left out where it could not be measured.
+    for (Measurement &candidate : measurements) {
+        candidate.paretoOptimal = std::none_of(measurements.begin(), measurements.end(), [&](const Measurement &other) {
+            const bool memoryKnown = other.peakKiB >= 0 && candidate.peakKiB >= 0;
+            const bool noWorse = other.hitRate >= candidate.hitRate && other.meanMsecs <= candidate.meanMsecs &&
+                                 other.p95Msecs <= candidate.p95Msecs &&
+                                 (!memoryKnown || other.peakKiB <= candidate.peakKiB);
+            const bool better = other.hitRate > candidate.hitRate || other.meanMsecs < candidate.meanMsecs ||
+                                other.p95Msecs < candidate.p95Msecs ||
+                                (memoryKnown && other.peakKiB < candidate.peakKiB);
+            return noWorse && better;
+        });
+    }
+    return measurements;
+}
+
+static QString binarizerName(Binarizer binarizer) {
+    switch (binarizer) {
+    case Binarizer::LocalAverage: return "LocalAverage";
+    case Binarizer::GlobalHistogram: return "GlobalHistogram";
+    case Binarizer::FixedThreshold: return "FixedThreshold";
+    case Binarizer::BoolCast: return "BoolCast";
+    }
+    return QString();
+}
+
+QString OptionsTuner::table(const QList<Measurement> &measurements) {
+    QList<Measurement> sorted = measurements;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Measurement &a, const Measurement &b) {
+        return a.hitRate != b.hitRate ? a.hitRate > b.hitRate : a.meanMsecs < b.meanMsecs;
+    });
+
+    auto flag = [](bool set) { return set ? QString("x") : QString("-"); };
+    QStringList lines;
+    lines << "   harder rotate invert downscale pure binarizer       max   hit%   mean ms    p95 ms  peak KiB";
+    for (const Measurement &m : sorted) {
+        const ReaderOptions &o = m.options;
+        lines << QString("%1%2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12 %13")
+                     .arg(m.paretoOptimal ? "*" : " ")
+                     .arg(m.isDefault ? "d" : " ")
+                     .arg(flag(o.tryHarder()), 6)
+                     .arg(flag(o.tryRotate()), 6)
+                     .arg(flag(o.tryInvert()), 6)
+                     .arg(flag(o.tryDownscale()), 9)
+                     .arg(flag(o.isPure()), 4)
+                     .arg(binarizerName(o.binarizer()), -15)
+                     .arg(int(o.maxNumberOfSymbols()), 3)
+                     .arg(m.hitRate * 100, 6, 'f', 1)
+                     .arg(m.meanMsecs, 9, 'f', 2)
+                     .arg(m.p95Msecs, 9, 'f', 2)
+                     .arg(m.peakKiB >= 0 ? QString::number(m.peakKiB) : QString("n/a"), 9);
+    }
+    lines << "* Pareto optimal (hit rate vs. mean and p95 latency and peak memory), d current defaults";
+    return lines.join('\n');
+}
@@ -0,0 +1,48 @@
+#ifndef OPTIONSTUNER_H
+#define OPTIONSTUNER_H
+
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+// Sweeps combinations of ReaderOptions over a local image corpus and
+// measures what each one costs and finds, to settle which options are worth
+// enabling. The images of a setting are decoded in parallel, settings run
+// one after the other so their memory can be told apart. Images are read
+// from disk a batch at a time for every setting, only that batch is in
+// memory and loading it is left out of both latency and peak memory.
+class OptionsTuner {
+public:
+    struct Measurement {
+        ZXingQt::ReaderOptions options;
+        double hitRate;      // share of all codes found by any setting
+        double meanMsecs;    // per image
+        double p95Msecs;
+        qint64 peakKiB;      // resident memory above the baseline, -1 if unknown
+        bool paretoOptimal;  // no other setting finds as much for less time and memory
+        bool isDefault;      // the options ImageDecoder uses
+    };
+
+    // Formats, text mode and the default settings are taken from base.
+    explicit OptionsTuner(const ZXingQt::ReaderOptions &base);
+
+    // Collects the readable images below the directory, of which the first
+    // frame is decoded.
+    int loadCorpus(const QString &directory);
+
+    QList<Measurement> run();
+
+    // Sorted by hit rate, then mean latency, Pareto optimal rows are marked.
+    static QString table(const QList<Measurement> &measurements);
+
+private:
+    QList<ZXingQt::ReaderOptions> settings() const;
+
+    ZXingQt::ReaderOptions base;
+    QStringList imagePaths;
+};
+
+#endif // OPTIONSTUNER_H
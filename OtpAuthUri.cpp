@@ -0,0 +1,29 @@
+#include "OtpAuthUri.h"
+#include <QUrl>
+#include <QUrlQuery>
+
+OtpAuthUri OtpAuthUri::parse(const QString &text) {
+    QUrl url(text);
+    QUrlQuery query(url);
+    OtpAuthUri uri;
+    uri.type = url.host();
+    uri.label = url.path(QUrl::FullyDecoded).mid(1); // Remove leading '/'
+
+    uri.account = uri.label.section(':', -1).trimmed();
+    uri.issuer = query.queryItemValue("issuer", QUrl::FullyDecoded);
+    if (uri.issuer.isEmpty() && uri.label.contains(':')) {
+        uri.issuer = uri.label.section(':', 0, -2).trimmed();
+    }
+    uri.secret = query.queryItemValue("secret", QUrl::FullyDecoded);
+    uri.algorithm = query.hasQueryItem("algorithm") ? query.queryItemValue("algorithm").toUpper() : "SHA1";
+    if (query.hasQueryItem("digits")) {
+        uri.digits = query.queryItemValue("digits").toInt();
+    }
+    if (query.hasQueryItem("period")) {
+        uri.period = query.queryItemValue("period").toInt();
+    }
+    if (query.hasQueryItem("counter")) {
+        uri.counter = query.queryItemValue("counter").toLongLong();
+    }
+    return uri;
+}
@@ -0,0 +1,23 @@
+#ifndef OTPAUTHURI_H
+#define OTPAUTHURI_H
+
+#include <QString>
+
+// Fields of an otpauth://TYPE/LABEL?PARAMETERS key URI, parameters that are
+// not given hold their documented defaults.
+struct OtpAuthUri {
+    QString type; // totp or hotp
+    QString label;
+    QString issuer; // from the parameter, else the label prefix
+    QString account;
+    QString secret;
+    QString algorithm;
+    int digits = 6;
+    int period = 30; // totp only
+    qint64 counter = 0; // hotp only
+
+    static bool isOtpAuthUri(const QString &text) { return text.startsWith("otpauth://"); }
+    static OtpAuthUri parse(const QString &text);
+};
+
+#endif // OTPAUTHURI_H
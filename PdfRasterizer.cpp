@@ -0,0 +1,57 @@
+#include "PdfRasterizer.h"
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QPdfDocumentRenderOptions>
+#include <QtMath>
+
+PdfRasterizer::PdfRasterizer(const ImageSource &source) : document(nullptr) {
+    if (source.filePath.isEmpty()) {
+        buffer.setData(source.data);
+        buffer.open(QIODevice::ReadOnly);
+        document.load(&buffer);
+    } else {
+        document.load(source.filePath);
+    }
+}
+
+bool PdfRasterizer::isPdf(const ImageSource &source) {
+    if (source.filePath.isEmpty()) {
+        return source.format == "pdf" || source.data.startsWith("%PDF-");
+    }
+    return QFileInfo(source.filePath).suffix().compare("pdf", Qt::CaseInsensitive) == 0;
+}
+
+QSizeF PdfRasterizer::pagePointSize(int page) const {
+    QMutexLocker locker(&mutex);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    return document.pageSize(page);
+#else
+    return document.pagePointSize(page);
+#endif
+}
+
+QImage PdfRasterizer::render(int page, qreal dpi, const QRectF &clip) const {
+    QMutexLocker locker(&mutex);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    const QSizeF points = document.pageSize(page);
+#else
+    const QSizeF points = document.pagePointSize(page);
+#endif
+    const qreal scale = dpi / 72;
+    const QSize pageSize(qCeil(points.width() * scale), qCeil(points.height() * scale));
+    if (!clip.isValid()) {
+        return document.render(page, pageSize);
+    }
+
+    const QRect clipRect = QRectF(clip.topLeft() * scale, clip.size() * scale).toAlignedRect() &
+                           QRect(QPoint(0, 0), pageSize);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    // No clipped rendering before Qt 6, the region is cut from the page.
+    return document.render(page, pageSize).copy(clipRect);
+#else
+    QPdfDocumentRenderOptions options;
+    options.setScaledSize(pageSize);
+    options.setScaledClipRect(clipRect);
+    return document.render(page, clipRect.size(), options);
+#endif
+}
@@ -0,0 +1,34 @@
+#ifndef PDFRASTERIZER_H
+#define PDFRASTERIZER_H
+
+#include <QBuffer>
+#include <QImage>
+#include <QMutex>
+#include <QPdfDocument>
+#include <QRectF>
+
+#include "ImageDecoder.h"
+
+// Renders pages of a PDF source with QtPdf at a chosen resolution, either
+// whole or only a region of them. PDFium renders one page at a time per
+// process, so render() serializes and may be called from any thread while
+// the rendered pages are decoded in parallel.
+class PdfRasterizer {
+public:
+    explicit PdfRasterizer(const ImageSource &source);
+
+    static bool isPdf(const ImageSource &source);
+
+    int pageCount() const { return document.pageCount(); }
+    QSizeF pagePointSize(int page) const;
+
+    // Renders the page, or only clip (in points) if it is valid, at dpi.
+    QImage render(int page, qreal dpi, const QRectF &clip = QRectF()) const;
+
+private:
+    QBuffer buffer;
+    mutable QMutex mutex;
+    mutable QPdfDocument document;
+};
+
+#endif // PDFRASTERIZER_H
@@ -0,0 +1,195 @@
+#include "QrRenderer.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+#include "BitMatrix.h"
+#include "MultiFormatWriter.h"
+
+#include "OtpAuthUri.h"
+
+static const int QuietZone = 4;
+static const int MemoryCacheBytes = 64 * 1024 * 1024;
+
+QrRenderer::QrRenderer(const QString &cacheDir)
+    : cacheDir(cacheDir), modulePixels(8), memoryCache(MemoryCacheBytes) {
+    if (cacheDir.isEmpty()) {
+        return;
+    }
+    // Only the user may list or read the cached secrets.
+    if (!QDir().mkpath(cacheDir) ||
+        !QFile::setPermissions(cacheDir, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner)) {
+        qWarning() << "failed to create private cache directory" << cacheDir;
+        this->cacheDir.clear();
+    }
+}
+
+QString QrRenderer::defaultCacheDir() {
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("qr");
+}
+
+QByteArray QrRenderer::cacheKey(const QString &text) const {
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(text.toUtf8());
+    hash.addData(QByteArray::number(modulePixels));
+    return hash.result().toHex();
+}
+
+QString QrRenderer::cachePath(const QString &text) const {
+    if (cacheDir.isEmpty()) {
+        return QString();
+    }
+    return QDir(cacheDir).filePath(QString::fromLatin1(cacheKey(text)) + ".png");
+}
+
+QImage QrRenderer::encode(const QString &text) const {
+    ZXing::BitMatrix matrix;
+    try {
+        // Without a requested size the matrix holds one pixel per module.
+        matrix = ZXing::MultiFormatWriter(ZXing::BarcodeFormat::QRCode).setMargin(0).encode(text.toStdString(), 0, 0);
+    } catch (const std::exception &e) {
+        qWarning() << "failed to encode" << text << ":" << e.what();
+        return QImage();
+    }
+
+    const int modules = matrix.width() + 2 * QuietZone;
+    QImage image(modules * modulePixels, modules * modulePixels, QImage::Format_Grayscale8);
+    image.fill(255);
+    for (int y = 0; y < matrix.height(); ++y) {
+        for (int x = 0; x < matrix.width(); ++x) {
+            if (!matrix.get(x, y)) {
+                continue;
+            }
+            for (int row = 0; row < modulePixels; ++row) {
+                uchar *line = image.scanLine((y + QuietZone) * modulePixels + row);
+                memset(line + (x + QuietZone) * modulePixels, 0, size_t(modulePixels));
+            }
+        }
+    }
+    return image;
+}
+
+QImage QrRenderer::render(const QString &text) const {
+    const QByteArray key = cacheKey(text);
+    {
+        QMutexLocker locker(&mutex);
+        if (const QImage *cached = memoryCache.object(key)) {
+            return *cached;
+        }
+    }
+    const QString path = cachePath(text);
+    QImage image = path.isEmpty() ? QImage() : QImage(path);
+    if (image.isNull()) {
+        image = encode(text);
+        if (!image.isNull() && !path.isEmpty()) {
+            // Written to a temporary file first, concurrent renders of the
+            // same text never see a partial PNG.
+            QSaveFile file(path);
+            if (!file.open(QIODevice::WriteOnly) ||
+                !file.setPermissions(QFile::ReadOwner | QFile::WriteOwner) || !image.save(&file, "PNG") ||
+                !file.commit()) {
+                qWarning() << "failed to cache" << path;
+            }
+        }
+    }
+    if (!image.isNull()) {
+        QMutexLocker locker(&mutex);
+        memoryCache.insert(key, new QImage(image), int(image.sizeInBytes()));
+    }
+    return image;
+}
+
+static QString labelOf(const QString &text) {
+    if (OtpAuthUri::isOtpAuthUri(text)) {
+        OtpAuthUri uri = OtpAuthUri::parse(text);
+        return uri.issuer.isEmpty() || uri.label.startsWith(uri.issuer) ? uri.label
+                                                                        : uri.issuer + ": " + uri.account;
+    }
+    return text.left(40);
+}
+
+int QrRenderer::writePngSet(const QStringList &texts, const QString &directory) const {
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "failed to create" << directory;
+        return 0;
+    }
+    QList<int> indices;
+    for (int i = 0; i < texts.size(); ++i) {
+        indices.append(i);
+    }
+    const int digits = QString::number(texts.size()).size();
+    std::function<int(int)> write = [this, &texts, &directory, digits](int index) {
+        QString name = labelOf(texts[index]);
+        name.replace(QRegularExpression("[^A-Za-z0-9._-]+"), "_");
+        const QString path =
+            QDir(directory).filePath(QString("%1-%2.png").arg(index + 1, digits, 10, QChar('0')).arg(name));
+
+        // A symbol in the disk cache is copied as is, no PNG decode or
+        // encode.
+        const QString cached = cachePath(texts[index]);
+        QImage image;
+        if (cached.isEmpty() || !QFile::exists(cached)) {
+            image = render(texts[index]);
+        }
+        QFile::remove(path);
+        if (!cached.isEmpty() && QFile::exists(cached)) {
+            return QFile::copy(cached, path) ? 1 : 0;
+        }
+        return !image.isNull() && image.save(path, "PNG") ? 1 : 0;
+    };
+    QList<int> written = QtConcurrent::blockingMapped<QList<int>>(indices, write);
+    return std::accumulate(written.begin(), written.end(), 0);
+}
+
+int QrRenderer::writeSheet(const QStringList &texts, const QString &pdfPath) const {
+    QPdfWriter writer(pdfPath);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setPageMargins(QMarginsF(15, 15, 15, 15), QPageLayout::Millimeter);
+    writer.setTitle("OTP accounts");
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        qWarning() << "failed to write" << pdfPath;
+        return 0;
+    }
+
+    const int columns = 3;
+    const int rows = 4;
+    const QRect page = painter.viewport();
+    const int cellWidth = page.width() / columns;
+    const int cellHeight = page.height() / rows;
+    const int labelHeight = painter.fontMetrics().height() * 2;
+    const int edge = qMin(cellWidth, cellHeight - labelHeight) * 9 / 10;
+
+    // Symbols are rendered in parallel one page at a time, painting stays
+    // on this thread.
+    int placed = 0;
+    std::function<QImage(const QString &)> renderOne = [this](const QString &text) { return render(text); };
+    for (int first = 0; first < texts.size(); first += columns * rows) {
+        const QStringList pageTexts = texts.mid(first, columns * rows);
+        const QList<QImage> symbols = QtConcurrent::blockingMapped<QList<QImage>>(pageTexts, renderOne);
+        if (first > 0) {
+            writer.newPage();
+        }
+        for (int i = 0; i < symbols.size(); ++i) {
+            const QRect cell((i % columns) * cellWidth, (i / columns) * cellHeight, cellWidth, cellHeight);
+            if (!symbols[i].isNull()) {
+                painter.drawImage(QRect(cell.center().x() - edge / 2, cell.top(), edge, edge), symbols[i]);
+                ++placed;
+            }
+            painter.drawText(QRect(cell.left(), cell.top() + edge, cellWidth, labelHeight),
+                             Qt::AlignHCenter | Qt::AlignTop | Qt::TextWordWrap, labelOf(pageTexts[i]));
+        }
+    }
+    painter.end();
+    return placed;
+}
@@ -0,0 +1,50 @@
+#ifndef QRRENDERER_H
+#define QRRENDERER_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+// Renders texts (usually otpauth:// URIs) as clean QR codes with the zxing
+// writer. Rendered symbols are cached in memory keyed by a hash of text and
+// module size, so rendering an account a second time is free. The symbols
+// carry secrets, so they are only written to a disk cache (user-only
+// permissions) when one is given. Safe to use from several threads.
+class QrRenderer {
+public:
+    // An empty cacheDir keeps the cache in memory only.
+    explicit QrRenderer(const QString &cacheDir = QString());
+
+    static QString defaultCacheDir();
+
+    // Pixels per module, the quiet zone is four modules wide.
+    int moduleSize() const { return modulePixels; }
+    void setModuleSize(int pixels) { modulePixels = qMax(1, pixels); }
+
+    // Null image if the text does not fit into a QR code.
+    QImage render(const QString &text) const;
+
+    // One PNG per text, named by index and label. Returns the number of
+    // files written.
+    int writePngSet(const QStringList &texts, const QString &directory) const;
+    // Paginated PDF sheet with the label below each symbol. Returns the
+    // number of symbols placed.
+    int writeSheet(const QStringList &texts, const QString &pdfPath) const;
+
+private:
+    QByteArray cacheKey(const QString &text) const;
+    // Path in the disk cache, empty without one.
+    QString cachePath(const QString &text) const;
+    QImage encode(const QString &text) const;
+
+    QString cacheDir;
+    int modulePixels;
+    mutable QMutex mutex;
+    mutable QCache<QByteArray, QImage> memoryCache; // cost in bytes
+
+};
+
+#endif // QRRENDERER_H
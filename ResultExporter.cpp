@@ -0,0 +1,152 @@
+#include "ResultExporter.h"
+#include <QDebug>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <cstdio>
+
+#include "OtpAuthUri.h"
+
+static const QStringList csvColumns = {"source", "page", "format", "text", "type", "label", "issuer", "account",
+                                       "secret", "algorithm", "digits", "period", "counter"};
+
+ResultExporter::ResultExporter(QIODevice *device, Format format) : device(device), format(format), records(0) {
+    if (format == Csv) {
+        writeCsvRow(csvColumns);
+    }
+}
+
+bool ResultExporter::formatFromName(const QString &name, Format &format) {
+    if (name == "jsonl") {
+        format = JsonLines;
+    } else if (name == "csv") {
+        format = Csv;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ResultExporter::write(const QList<PageResult> &pages) {
+    for (const PageResult &page : pages) {
+        for (const ZXingQt::Result &barcode : page.barcodes) {
+            QJsonObject record{{"source", page.source},
+                               {"page", page.page},
+                               {"format", barcode.formatName()},
+                               {"text", barcode.text()}};
+            if (OtpAuthUri::isOtpAuthUri(barcode.text())) {
+                OtpAuthUri uri = OtpAuthUri::parse(barcode.text());
+                record.insert("type", uri.type);
+                record.insert("label", uri.label);
+                record.insert("issuer", uri.issuer);
+                record.insert("account", uri.account);
+                record.insert("secret", uri.secret);
+                record.insert("algorithm", uri.algorithm);
+                record.insert("digits", uri.digits);
+                if (uri.type == "hotp") {
+                    record.insert("counter", uri.counter);
+                } else {
+                    record.insert("period", uri.period);
+                }
+            }
+
+            if (format == JsonLines) {
+                device->write(QJsonDocument(record).toJson(QJsonDocument::Compact) + "\n");
+            } else {
+                QStringList fields;
+                for (const QString &column : csvColumns) {
+                    QJsonValue value = record.value(column);
+                    fields.append(value.isDouble() ? QString::number(qint64(value.toDouble())) : value.toString());
+                }
+                writeCsvRow(fields);
+            }
+            ++records;
+        }
+    }
+}
+
+void ResultExporter::flush() {
+    if (QFileDevice *file = qobject_cast<QFileDevice *>(device)) {
+        file->flush();
+    }
+}
+
+void ResultExporter::writeCsvRow(const QStringList &fields) {
+    // RFC 4180, fields with separators, quotes or line breaks are quoted.
+    QStringList row;
+    for (QString field : fields) {
+        if (field.contains(',') || field.contains('"') || field.contains('\n') || field.contains('\r')) {
+            field = '"' + field.replace('"', "\"\"") + '"';
+        }
+        row.append(field);
+    }
+    device->write(row.join(',').toUtf8() + "\r\n");
+}
+
+ExportJob::ExportJob(const QStringList &inputs, ResultExporter *exporter, QObject *parent)
+    : QObject(parent), inputs(inputs), nextInput(0), exporter(exporter), outstanding(0),
+      window(4 * QThreadPool::globalInstance()->maxThreadCount()), withoutCodes(0) {
+    connect(&queue, &IngestQueue::sourceDecoded, this, &ExportJob::sourceDecoded);
+}
+
+int ExportJob::exec() {
+    QEventLoop loop;
+    connect(&queue, &IngestQueue::finished, &loop, &QEventLoop::quit);
+    refill();
+    if (outstanding > 0) {
+        loop.exec();
+    }
+    if (withoutCodes > 0) {
+        qWarning() << withoutCodes << "images without any code";
+    }
+    return 0;
+}
+
+bool ExportJob::nextPath(QString &path) {
+    while (pathList.isOpen() || nextInput < inputs.size()) {
+        if (pathList.isOpen()) {
+            if (pathList.atEnd()) {
+                pathList.close();
+                continue;
+            }
+            path = QString::fromLocal8Bit(pathList.readLine()).trimmed();
+            if (!path.isEmpty()) {
+                return true;
+            }
+        } else if (inputs[nextInput] == "-") {
+            ++nextInput;
+            pathList.open(stdin, QIODevice::ReadOnly);
+        } else {
+            path = inputs[nextInput++];
+            return true;
+        }
+    }
+    return false;
+}
+
+void ExportJob::refill() {
+    QList<ImageSource> sources;
+    QString path;
+    while (outstanding + sources.size() < window && nextPath(path)) {
+        ImageSource source;
+        source.filePath = path;
+        source.name = path;
+        sources.append(source);
+    }
+    outstanding += sources.size();
+    if (!sources.isEmpty()) {
+        queue.enqueue(sources);
+    }
+}
+
+void ExportJob::sourceDecoded(const QString &, const QList<PageResult> &pages) {
+    --outstanding;
+    qint64 before = exporter->recordCount();
+    exporter->write(pages);
+    if (exporter->recordCount() == before) {
+        ++withoutCodes;
+    }
+    refill();
+}
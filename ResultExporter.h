@@ -0,0 +1,64 @@
+#ifndef RESULTEXPORTER_H
+#define RESULTEXPORTER_H
+
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+#include <QStringList>
+
+#include "IngestQueue.h"
+
+// Writes decoded barcodes as JSON Lines or CSV, one record per barcode with
+// the otpauth fields parsed out. Records are written as the results arrive,
+// nothing is kept afterwards.
+class ResultExporter {
+public:
+    enum Format { JsonLines, Csv };
+
+    ResultExporter(QIODevice *device, Format format);
+
+    // "jsonl" or "csv".
+    static bool formatFromName(const QString &name, Format &format);
+
+    void write(const QList<PageResult> &pages);
+    // Pushes buffered records out, for consumers that follow the output.
+    void flush();
+    qint64 recordCount() const { return records; }
+
+private:
+    void writeCsvRow(const QStringList &fields);
+
+    QIODevice *device;
+    Format format;
+    qint64 records;
+};
+
+// Command line export of many images: paths are read lazily and only a
+// window of them is handed to the decoder at a time, so neither the inputs
+// nor the results of a large batch are held in memory.
+class ExportJob : public QObject {
+    Q_OBJECT
+
+public:
+    // Inputs are image paths, "-" reads further paths from stdin, one per line.
+    ExportJob(const QStringList &inputs, ResultExporter *exporter, QObject *parent = nullptr);
+
+    // Runs until every image has been decoded and written, returns the exit code.
+    int exec();
+
+private:
+    bool nextPath(QString &path);
+    void refill();
+    void sourceDecoded(const QString &name, const QList<PageResult> &pages);
+
+    QStringList inputs;
+    int nextInput;
+    QFile pathList;
+    ResultExporter *exporter;
+    IngestQueue queue;
+    int outstanding;
+    int window;
+    int withoutCodes;
+};
+
+#endif // RESULTEXPORTER_H
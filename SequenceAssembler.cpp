@@ -0,0 +1,126 @@
+#include "SequenceAssembler.h"
+#include <QUrl>
+#include <QUrlQuery>
+
+using namespace ZXingQt;
+
+static bool readVarint(const QByteArray &data, int &pos, quint64 &value) {
+    value = 0;
+    for (int shift = 0; pos < data.size() && shift < 64; shift += 7) {
+        uchar byte = uchar(data[pos++]);
+        value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads batch_size (3), batch_index (4) and batch_id (5) of the
+// MigrationPayload protobuf message carried in the data parameter.
+static bool parseMigrationBatch(const QString &text, int &index, int &size, qint64 &id) {
+    if (!text.startsWith("otpauth-migration://")) {
+        return false;
+    }
+    QUrlQuery query{QUrl(text)};
+    QByteArray data = QByteArray::fromBase64(query.queryItemValue("data", QUrl::FullyDecoded).toLatin1());
+
+    index = 0;
+    size = 1;
+    id = 0;
+    int pos = 0;
+    while (pos < data.size()) {
+        quint64 tag, value;
+        if (!readVarint(data, pos, tag)) {
+            return false;
+        }
+        switch (tag & 7) {
+        case 0: // varint
+            if (!readVarint(data, pos, value)) {
+                return false;
+            }
+            if (tag >> 3 == 3) {
+                size = int(value);
+            } else if (tag >> 3 == 4) {
+                index = int(value);
+            } else if (tag >> 3 == 5) {
+                id = qint64(value);
+            }
+            break;
+        case 2: // length delimited, the otp parameters
+            if (!readVarint(data, pos, value) || value > quint64(data.size() - pos)) {
+                return false;
+            }
+            pos += int(value);
+            break;
+        case 1:
+            pos += 8;
+            break;
+        case 5:
+            pos += 4;
+            break;
+        default:
+            return false;
+        }
+    }
+    return pos == data.size() && size > 0 && index >= 0 && index < size;
+}
+
+bool SequenceAssembler::add(const QList<Result> &results) {
+    bool isSequence = false;
+    for (const Result &result : results) {
+        int index, count;
+        qint64 id;
+        if (result.sequenceSize() > 1) {
+            structuredAppend = true;
+            isSequence = true;
+            // The parity byte is the same for every symbol of a sequence.
+            addPart("sa:" + result.sequenceId(), result.sequenceIndex(), result.sequenceSize(), result.text());
+        } else if (parseMigrationBatch(result.text(), index, count, id) && count > 1) {
+            structuredAppend = false;
+            isSequence = true;
+            addPart(QString("migration:%1").arg(id), index, count, result.text());
+        }
+    }
+    return isSequence;
+}
+
+bool SequenceAssembler::addPart(const QString &key, int index, int count, const QString &text) {
+    if (key != this->key || count != size) {
+        reset();
+        this->key = key;
+        size = count;
+    }
+    if (index < 0 || index >= size || parts.contains(index)) {
+        return false;
+    }
+    parts.insert(index, text);
+    return true;
+}
+
+void SequenceAssembler::reset() {
+    key.clear();
+    parts.clear();
+    size = 0;
+}
+
+QList<int> SequenceAssembler::missing() const {
+    QList<int> indices;
+    for (int i = 0; i < size; ++i) {
+        if (!parts.contains(i)) {
+            indices.append(i);
+        }
+    }
+    return indices;
+}
+
+QStringList SequenceAssembler::texts() const {
+    if (structuredAppend) {
+        QString text;
+        for (const QString &part : parts) {
+            text += part;
+        }
+        return {text};
+    }
+    return parts.values();
+}
@@ -0,0 +1,41 @@
+#ifndef SEQUENCEASSEMBLER_H
+#define SEQUENCEASSEMBLER_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+#include "ZXingQt/ZXingQtReader.h"
+
+// Collects the parts of a multi-code sequence that are shown one after the
+// other: QR structured append symbols and batches of otpauth-migration
+// exports. Parts already captured are ignored, the sequence is complete as
+// soon as the last missing part arrives.
+class SequenceAssembler {
+public:
+    SequenceAssembler() : size(0), structuredAppend(false) {}
+
+    // Returns false if none of the results is part of a sequence.
+    bool add(const QList<ZXingQt::Result> &results);
+    void reset();
+
+    int captured() const { return parts.size(); }
+    int total() const { return size; }
+    bool isComplete() const { return size > 0 && parts.size() == size; }
+    QList<int> missing() const;
+
+    // Structured append parts are joined to the original text, migration
+    // batches keep one URI per part.
+    QStringList texts() const;
+
+private:
+    bool addPart(const QString &key, int index, int count, const QString &text);
+
+    QString key;
+    QMap<int, QString> parts;
+    int size;
+    bool structuredAppend;
+};
+
+#endif // SEQUENCEASSEMBLER_H
@@ -8,35 +8,52 @@
 #include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <QDateTime>
 #include <QtConcurrent>
+#include <QtMath>
 
 using namespace ZXingQt;
 
 WebcamQRCodeWidget::WebcamQRCodeWidget(QWidget *parent)
-    : QWidget(parent), camera(nullptr), processingInProgress(false) {
+    : QWidget(parent), decodesInFlight(0), nextFeed(0),
+      configuredBudget(DecodeScheduler::budgetFromString(qEnvironmentVariable("QOTPDECODE_CPU_BUDGET"), 0)) {
+    decodePool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 2));
+    frameThresholds = FrameQualityFilter::Thresholds::fromString(qEnvironmentVariable("QOTPDECODE_FRAME_FILTER"));
     setupUI();
     populateCameraList();
 }
 
 WebcamQRCodeWidget::~WebcamQRCodeWidget() {
-    if (camera) {
-        camera->stop();
-        delete camera;
+    stopCameras();
+    // No decode outlives the widget, cancelled ones end after their pass.
+    decodePool.waitForDone();
+}
+
+void WebcamQRCodeWidget::stopCameras() {
+    for (CameraFeed *feed : feeds) {
+        disconnect(feed->frameConnection);
+        feed->session->cancel();
+        feed->camera->stop();
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        delete feed->capture;
+#endif
+        delete feed->camera;
+        delete feed->viewfinder;
+        delete feed;
     }
+    feeds.clear();
+    nextFeed = 0;
 }
 
 void WebcamQRCodeWidget::setupUI() {
     QVBoxLayout *layout = new QVBoxLayout(this);
 
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    viewfinder = new QCameraViewfinder();
-    capture = new QVideoProbe(this);
-#else
-    viewfinder = new QVideoWidget();
-    viewfinder->setFixedSize(256,256);
-    capture = new QMediaCaptureSession();
-#endif
-    layout->addWidget(viewfinder);
+    QWidget *viewfinderArea = new QWidget(this);
+    viewfinderArea->setFixedSize(256, 256);
+    viewfinderGrid = new QGridLayout(viewfinderArea);
+    viewfinderGrid->setContentsMargins(0, 0, 0, 0);
+    viewfinderGrid->setSpacing(2);
+    layout->addWidget(viewfinderArea);
 
     cameraComboBox = new QComboBox(this);
     layout->addWidget(cameraComboBox);
@@ -56,6 +73,10 @@ void WebcamQRCodeWidget::populateCameraList() {
     for (const CameraInfoEx &cameraInfoEx : sortedCameras) {
         cameraComboBox->addItem(cameraInfoEx.cameraInfo.description(), QVariant::fromValue(cameraInfoEx.cameraInfo));
     }
+    if (sortedCameras.size() > 1) {
+        // Entry without camera data, scans every device at once.
+        cameraComboBox->addItem("All cameras");
+    }
     if (!sortedCameras.isEmpty()) {
         cameraComboBox->setCurrentIndex(0);
         onCameraSelected(0);
@@ -111,35 +132,76 @@ WebcamQRCodeWidget::CameraInfoEx WebcamQRCodeWidget::getCameraInfoEx(const CAM_I
 }
 
 void WebcamQRCodeWidget::onCameraSelected(int index) {
-    CAM_INFO cameraInfo = cameraComboBox->itemData(index).value<CAM_INFO>();
-    startCamera(cameraInfo);
+    Q_UNUSED(index);
+    startCameras(selectedCameras());
 }
 
-void WebcamQRCodeWidget::startCamera(const CAM_INFO &cameraInfo) {
+QList<CAM_INFO> WebcamQRCodeWidget::selectedCameras() const {
+    QList<CAM_INFO> cameraInfos;
+    QVariant selected = cameraComboBox->currentData();
+    if (selected.isValid()) {
+        cameraInfos.append(selected.value<CAM_INFO>());
+    } else {
+        for (int i = 0; i < cameraComboBox->count(); ++i) {
+            QVariant data = cameraComboBox->itemData(i);
+            if (data.isValid()) {
+                cameraInfos.append(data.value<CAM_INFO>());
+            }
+        }
+    }
+    return cameraInfos;
+}
+
+void WebcamQRCodeWidget::startCameras(const QList<CAM_INFO> &cameraInfos) {
     if (!this->isVisible()) {
         return;
     }
-    if (camera) {
-        camera->stop();
-        delete camera;
-        camera = nullptr;
-    }
-    camera = new QCamera(cameraInfo, this);
+    // Decodes of the previous cameras are cancelled, not waited for.
+    stopCameras();
+
+    // Without a configured budget every camera gets a core, as when each
+    // one decoded on its own.
+    scheduler.setBudget(configuredBudget > 0 ? configuredBudget : qMax(1, int(cameraInfos.size())));
 
-    setCameraResolution(camera);
+    const int columns = qCeil(qSqrt(cameraInfos.size()));
+    const int edge = 256 / qMax(1, columns) - (columns > 1 ? viewfinderGrid->spacing() : 0);
+    for (const CAM_INFO &cameraInfo : cameraInfos) {
+        CameraFeed *feed = new CameraFeed;
+        feed->session.reset(new DecodeSession);
+        feed->filter.reset(new FrameQualityFilter(frameThresholds));
+        feed->jpeg.reset(new JpegLumaDecoder(&framePool));
+        feed->luma.reset(new LumaConverter(&framePool));
+        feed->pyramid.reset(new LumaPyramid(&framePool));
+        feed->camera = new QCamera(cameraInfo, this);
+
+        setCameraResolution(feed->camera);
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    capture->setSource(camera);
-    camera->setViewfinder(viewfinder);
-    connect(capture, &QVideoProbe::videoFrameProbed, this, &WebcamQRCodeWidget::processFrame);
+        feed->viewfinder = new QCameraViewfinder();
+        feed->capture = new QVideoProbe(feed->camera);
+        feed->capture->setSource(feed->camera);
+        feed->camera->setViewfinder(feed->viewfinder);
+        // The probe is the context, a frame queued for a deleted feed is
+        // dropped together with it.
+        feed->frameConnection = connect(feed->capture, &QVideoProbe::videoFrameProbed, feed->capture,
+                                        [this, feed](const QVideoFrame &frame) { processFrame(feed, frame); });
 #else
-    capture->setCamera(camera);
-    capture->setVideoOutput(viewfinder);
-    connect(viewfinder->videoSink(), &QVideoSink::videoFrameChanged, this, &WebcamQRCodeWidget::processFrame);
+        feed->viewfinder = new QVideoWidget();
+        feed->capture = new QMediaCaptureSession();
+        feed->capture->setCamera(feed->camera);
+        feed->capture->setVideoOutput(feed->viewfinder);
+        // The sink is the context, a frame queued for a deleted feed is
+        // dropped together with it.
+        feed->frameConnection = connect(feed->viewfinder->videoSink(), &QVideoSink::videoFrameChanged,
+                                        feed->viewfinder->videoSink(),
+                                        [this, feed](const QVideoFrame &frame) { processFrame(feed, frame); });
 #endif
+        feed->viewfinder->setFixedSize(edge, edge);
+        viewfinderGrid->addWidget(feed->viewfinder, feeds.size() / columns, feeds.size() % columns);
+        feeds.append(feed);
 
-    
-    camera->start();
+        feed->camera->start();
+    }
 }
 
 void WebcamQRCodeWidget::setCameraResolution(QCamera *camera) {
@@ -161,54 +223,147 @@ void WebcamQRCodeWidget::setCameraResolution(QCamera *camera) {
     */
 }
 
-void WebcamQRCodeWidget::processFrame(const QVideoFrame &frame) {
-    // only start qr detection when idle and the frame is valid.
-    if (processingInProgress || !frame.isValid()) {
+void WebcamQRCodeWidget::processFrame(CameraFeed *feed, const QVideoFrame &frame) {
+    // only queue frames for qr detection when they are valid.
+    if (!frame.isValid()) {
         return;
     }
+    feed->pendingFrame = frame;
+    scheduleDecodes();
+}
 
-    // Run qr detection in background to keep framerate up.
-    processingInProgress = true;
-    static_cast<void>(QtConcurrent::run([this, frame]() {
-        QList<Result> results = ReadBarcodes(frame);
-        if (!results.empty()) {
-            emit qrCodeDetected(results);
-            /*
-            QByteArray newData;
-            for (auto result: results) {
-                newData.append("||");
-                if (result.isValid()) {
-                    newData.append(result.bytes());
-                } else {
-                    newData.append("##");
+// Maps what the filter and decode saw to the scheduler's view of the scene.
+static DecodeScheduler::Outcome outcomeOf(FrameQualityFilter::Verdict verdict, bool motion, bool located,
+                                          bool decoded) {
+    switch (verdict) {
+    case FrameQualityFilter::SkipStatic:
+        return DecodeScheduler::Static;
+    case FrameQualityFilter::SkipBlurry:
+    case FrameQualityFilter::SkipExposure:
+        return DecodeScheduler::Rejected;
+    case FrameQualityFilter::Deferred:
+        return motion ? DecodeScheduler::Motion : DecodeScheduler::Deferred;
+    case FrameQualityFilter::Decode:
+        break;
+    }
+    if (decoded) {
+        return DecodeScheduler::Decoded;
+    }
+    if (located) {
+        return DecodeScheduler::Located;
+    }
+    return motion ? DecodeScheduler::Motion : DecodeScheduler::Empty;
+}
+
+void WebcamQRCodeWidget::scheduleDecodes() {
+    // Fill the free decode slots, taking the feeds in turn so that a fast
+    // camera can not starve the others. Frames go through the frame filter
+    // as the CPU budget allows, zxing only runs on those admitted for a
+    // decode.
+    for (int checked = 0; checked < feeds.size() && decodesInFlight < decodePool.maxThreadCount(); ++checked) {
+        CameraFeed *feed = feeds[nextFeed];
+        nextFeed = (nextFeed + 1) % feeds.size();
+        if (!feed->pendingFrame.isValid() || !feed->session->tryBegin()) {
+            continue;
+        }
+        QVideoFrame frame = feed->pendingFrame;
+        feed->pendingFrame = QVideoFrame();
+        const DecodeScheduler::Admission admission = scheduler.admit();
+        if (admission == DecodeScheduler::Drop) {
+            // Over budget even for the filter, the frame is not touched.
+            feed->session->end();
+            continue;
+        }
+        ++decodesInFlight;
+        checked = -1;
+        const bool claimed = admission == DecodeScheduler::Decode;
+
+        // Run qr detection in background to keep framerate up. Results are
+        // delivered on the GUI thread and dropped once the session is
+        // cancelled.
+        // Blurry, badly exposed and unchanged frames are not decoded at all.
+        // MJPEG frames are decoded to luma only instead of converting them
+        // to a colour QImage, frames zxing can not read as they are are
+        // converted into a pooled luma plane. Luma planes are decoded on the
+        // coarsest level of their pyramid likely to hold a readable symbol
+        // first.
+        QSharedPointer<DecodeSession> session = feed->session;
+        QSharedPointer<FrameQualityFilter> filter = feed->filter;
+        QSharedPointer<JpegLumaDecoder> jpeg = feed->jpeg;
+        QSharedPointer<LumaConverter> luma = feed->luma;
+        QSharedPointer<LumaPyramid> pyramid = feed->pyramid;
+        FrameBufferPool *pool = &framePool;
+        static_cast<void>(QtConcurrent::run(&decodePool, [this, session, filter, jpeg, luma, pyramid, pool,
+                                                          frame, claimed]() {
+            const qint64 cpuStart = DecodeScheduler::threadCpuTime();
+            QList<Result> results;
+            bool located = false;
+            FrameQualityFilter::Verdict verdict = FrameQualityFilter::Decode;
+            auto decodeView = [&](const ZXing::ImageView &image) {
+                verdict = filter->check(image, claimed);
+                if (verdict == FrameQualityFilter::Decode) {
+                    results = pyramid->decode(image, [&](const ZXing::ImageView &level) {
+                        return session->decode(level, &located);
+                    });
                 }
+            };
+            if (JpegLumaDecoder::isJpeg(frame)) {
+                if (jpeg->decode(frame)) {
+                    decodeView(jpeg->image());
+                }
+            } else if (!VisitImageView(frame, decodeView) && luma->convert(frame)) {
+                decodeView(luma->image());
             }
-            
-            if (lastProcessedCodes.size() != newData.size() || newData.compare(lastProcessedCodes) != 0) {
-                lastProcessedCodes = newData;
-                emit qrCodeDetected(results);
+            if (filter->checkedFrames() % 300 == 0) {
+                qInfo().noquote() << filter->report() << "; pooled pixel buffers allocated:" << pool->allocations();
             }
-            */
-        }
-        processingInProgress = false;
-    }));
+            const DecodeScheduler::Outcome outcome = outcomeOf(verdict, filter->sawMotion(), located, !results.isEmpty());
+            const qint64 cpuTime = DecodeScheduler::threadCpuTime() - cpuStart;
+            session->end();
+            QMetaObject::invokeMethod(this, [this, session, results, cpuTime, outcome, claimed]() {
+                decodeFinished(session, results, cpuTime, outcome, claimed);
+            }, Qt::QueuedConnection);
+        }));
+    }
 }
 
+void WebcamQRCodeWidget::decodeFinished(const QSharedPointer<DecodeSession> &session, const QList<Result> &results,
+                                        qint64 cpuTime, DecodeScheduler::Outcome outcome, bool claimed) {
+    --decodesInFlight;
+    scheduler.finished(cpuTime, outcome, claimed);
+    if (scheduler.finishedFrames() % 300 == 0) {
+        qInfo().noquote() << scheduler.report();
+    }
+    if (!session->isCancelled() && !results.empty()) {
+        // Several cameras usually see the same code, and one camera sees it
+        // in many frames. Only report result sets with a code not seen in
+        // the last seconds.
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        const qint64 window = 2000;
+        for (auto it = recentCodes.begin(); it != recentCodes.end();) {
+            it = now - it.value() > window ? recentCodes.erase(it) : std::next(it);
+        }
+        bool isNew = false;
+        for (const Result &result : results) {
+            QByteArray code = result.isValid() ? result.bytes() : QByteArray("##");
+            isNew = isNew || !recentCodes.contains(code);
+            recentCodes.insert(code, now);
+        }
+        if (isNew) {
+            emit qrCodeDetected(results);
+        }
+    }
+    scheduleDecodes();
+}
 
 void WebcamQRCodeWidget::showEvent(QShowEvent *event) {
     QWidget::showEvent(event);
-    int index = cameraComboBox->currentIndex();
-    if (index >= 0) {
-        CAM_INFO cameraInfo = cameraComboBox->itemData(index).value<CAM_INFO>();
-        startCamera(cameraInfo);
+    if (cameraComboBox->currentIndex() >= 0) {
+        startCameras(selectedCameras());
     }
 }
 
 void WebcamQRCodeWidget::hideEvent(QHideEvent *event) {
     QWidget::hideEvent(event);
-    if (camera) {
-        camera->stop();
-        delete camera;
-        camera = NULL;
-    }
+    stopCameras();
 }
@@ -5,9 +5,13 @@
 #include <QCamera>
 #include <QComboBox>
 #include <QVBoxLayout>
+#include <QGridLayout>
+#include <QHash>
 #include <QLabel>
+#include <QThreadPool>
 #include <QVideoFrame>
 #include <QList>
+#include <QSharedPointer>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #include <QCameraViewfinder>
@@ -22,6 +26,12 @@
 #endif
 
 #include "ZXingQt/ZXingQtReader.h"
+#include "DecodeScheduler.h"
+#include "DecodeSession.h"
+#include "FrameQualityFilter.h"
+#include "JpegLumaDecoder.h"
+#include "LumaConverter.h"
+#include "LumaPyramid.h"
 
 Q_DECLARE_METATYPE(CAM_INFO);
 
@@ -41,26 +51,62 @@ protected:
 
 private slots:
     void onCameraSelected(int index);
-    void processFrame(const QVideoFrame &frame);
 
 private:
+    // One open capture device with its viewfinder. Every feed decodes at
+    // most one frame at a time, newer frames replace the pending one.
+    struct CameraFeed {
+        QCamera *camera;
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        QCameraViewfinder *viewfinder;
+        QVideoProbe *capture;
+#else
+        QVideoWidget *viewfinder;
+        QMediaCaptureSession *capture;
+#endif
+        QSharedPointer<DecodeSession> session;
+        QSharedPointer<FrameQualityFilter> filter;
+        QSharedPointer<JpegLumaDecoder> jpeg;
+        QSharedPointer<LumaConverter> luma;
+        QSharedPointer<LumaPyramid> pyramid;
+        QVideoFrame pendingFrame;
+        QMetaObject::Connection frameConnection;
+    };
+
     void setupUI();
     void populateCameraList();
-    void startCamera(const CAM_INFO &cameraInfo);
+    void startCameras(const QList<CAM_INFO> &cameraInfos);
     void setCameraResolution(QCamera *camera);
+    void stopCameras();
+    void processFrame(CameraFeed *feed, const QVideoFrame &frame);
+    void scheduleDecodes();
+    void decodeFinished(const QSharedPointer<DecodeSession> &session, const QList<ZXingQt::Result> &results,
+                        qint64 cpuTime, DecodeScheduler::Outcome outcome, bool claimed);
+    QList<CAM_INFO> selectedCameras() const;
 
     QComboBox *cameraComboBox;
-    QCamera *camera;
-    
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-    QCameraViewfinder *viewfinder;
-    QVideoProbe *capture;
-#else
-    QVideoWidget *viewfinder;
-    QMediaCaptureSession *capture;
-#endif
-    bool processingInProgress;
-    QByteArray lastProcessedCodes;
+    QGridLayout *viewfinderGrid;
+    QList<CameraFeed *> feeds;
+
+    // Luma planes of converted frames, shared by all feeds. Declared before
+    // decodePool so it outlives every decode.
+    FrameBufferPool framePool;
+
+    // Decodes of all feeds share this pool, feeds are served round robin.
+    QThreadPool decodePool;
+    int decodesInFlight;
+    int nextFeed;
+
+    // Paces decodes to the CPU budget from QOTPDECODE_CPU_BUDGET, one core
+    // per camera if it is not set (configuredBudget 0).
+    DecodeScheduler scheduler;
+    double configuredBudget;
+
+    // Tunable through the QOTPDECODE_FRAME_FILTER environment variable.
+    FrameQualityFilter::Thresholds frameThresholds;
+
+    // Codes recently reported by any feed, to suppress duplicates.
+    QHash<QByteArray, qint64> recentCodes;
 
     struct CameraInfoEx {
         CAM_INFO cameraInfo;
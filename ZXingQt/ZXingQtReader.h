@@ -126,6 +126,8 @@ public:
 	}
 
 	using ZXing::Result::isValid;
+	using ZXing::Result::sequenceSize;
+	using ZXing::Result::sequenceIndex;
 
 	BarcodeFormat format() const { return static_cast<BarcodeFormat>(ZXing::Result::format()); }
 	ContentType contentType() const { return static_cast<ContentType>(ZXing::Result::contentType()); }
@@ -134,6 +136,7 @@ public:
 	const QString& text() const { return _text; }
 	const QByteArray& bytes() const { return _bytes; }
 	const Position& position() const { return _position; }
+	QString sequenceId() const { return QString::fromStdString(ZXing::Result::sequenceId()); }
 
 	// For debugging/development
 	int runTime = 0;
@@ -148,6 +151,11 @@ inline QList<Result> QListResults(ZXing::Results&& zxres)
 	return res;
 }
 
+inline QList<Result> ReadBarcodes(const ZXing::ImageView& image, const ReaderOptions& opts = {})
+{
+	return QListResults(ZXing::ReadBarcodes(image, opts));
+}
+
 inline QList<Result> ReadBarcodes(const QImage& img, const ReaderOptions& opts = {})
 {
 	using namespace ZXing;
@@ -184,13 +192,15 @@ inline Result ReadBarcode(const QImage& img, const ReaderOptions& opts = {})
 }
 
 #ifdef QT_MULTIMEDIA_LIB
-inline QList<Result> ReadBarcodes(const QVideoFrame& frame, const ReaderOptions& opts = {})
+// Format of the first plane of a video frame as ZXing reads it, ImageFormat::None if the
+// frame has to be converted first. pixStride and pixOffset address the luma of packed YUV.
+inline ZXing::ImageFormat ImageFormatOf(const QVideoFrame& frame, int& pixStride, int& pixOffset)
 {
 	using namespace ZXing;
 
 	ImageFormat fmt = ImageFormat::None;
-	int pixStride = 0;
-	int pixOffset = 0;
+	pixStride = 0;
+	pixOffset = 0;
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
 #define FORMAT(F5, F6) QVideoFrame::Format_##F5
@@ -204,6 +214,10 @@ inline QList<Result> ReadBarcodes(const QVideoFrame& frame, const ReaderOptions&
 	case FORMAT(ARGB32, ARGB8888):
 	case FORMAT(ARGB32_Premultiplied, ARGB8888_Premultiplied):
 	case FORMAT(RGB32, RGBX8888):
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	case QVideoFrameFormat::Format_XRGB8888:
+	case QVideoFrameFormat::Format_RGBA8888:
+#endif
 #if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
 		fmt = ImageFormat::BGRX;
 #else
@@ -255,6 +269,9 @@ inline QList<Result> ReadBarcodes(const QVideoFrame& frame, const ReaderOptions&
 
 #if (QT_VERSION >= QT_VERSION_CHECK(5, 13, 0))
 	case FORMAT(ABGR32, ABGR8888):
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	case QVideoFrameFormat::Format_XBGR8888:
+#endif
 #if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
 		fmt = ImageFormat::RGBX;
 #else
@@ -268,6 +285,39 @@ inline QList<Result> ReadBarcodes(const QVideoFrame& frame, const ReaderOptions&
 	default: break;
 	}
 
+	return fmt;
+}
+
+// Maps the frame and calls f with a ZXing::ImageView of its first plane. Returns false if
+// the pixel format can not be read directly or the frame could not be mapped.
+template <typename F>
+bool VisitImageView(const QVideoFrame& frame, F&& f)
+{
+	int pixStride = 0;
+	int pixOffset = 0;
+	ZXing::ImageFormat fmt = ImageFormatOf(frame, pixStride, pixOffset);
+	auto img = frame; // shallow copy just get access to non-const map() function
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+	if (fmt == ZXing::ImageFormat::None || !img.isValid() || !img.map(QAbstractVideoBuffer::ReadOnly))
+#else
+	if (fmt == ZXing::ImageFormat::None || !img.isValid() || !img.map(QVideoFrame::ReadOnly))
+#endif
+		return false;
+	QScopeGuard unmap([&] { img.unmap(); });
+
+	f(ZXing::ImageView(img.bits(FIRST_PLANE) + pixOffset, img.width(), img.height(), fmt, img.bytesPerLine(FIRST_PLANE),
+					   pixStride));
+	return true;
+}
+
+inline QList<Result> ReadBarcodes(const QVideoFrame& frame, const ReaderOptions& opts = {})
+{
+	using namespace ZXing;
+
+	int pixStride = 0;
+	int pixOffset = 0;
+	ImageFormat fmt = ImageFormatOf(frame, pixStride, pixOffset);
+
 	if (fmt != ImageFormat::None) {
 		auto img = frame; // shallow copy just get access to non-const map() function
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -18,11 +18,17 @@
  *
  */
 
+#include <QAction>
 #include <QApplication>
 #include <QClipboard>
+#include <QCommandLineParser>
+#include <QDateTime>
 #include <QDragEnterEvent>
 #include <QDropEvent>
+#include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QHBoxLayout>
 #include <QIcon>
 #include <QImageReader>
@@ -34,18 +40,31 @@
 #include <QMimeData>
 #include <QPixmap>
 #include <QPushButton>
-#include <QRegularExpression>
+#include <QSet>
 #include <QStandardItem>
 #include <QStandardItemModel>
 #include <QTextEdit>
+#include <QTimer>
 #include <QToolTip>
 #include <QUrl>
 #include <QUrlQuery>
 #include <QVBoxLayout>
 #include <Qt>
+#include <QtConcurrent>
+#include <cstdio>
 
 #include "ZXingQt/ZXingQtReader.h"
+#include "DataUrlScanner.h"
+#include "DecodeHistory.h"
+#include "DecodeServer.h"
+#include "FolderWatcher.h"
+#include "ImageDecoder.h"
+#include "IngestQueue.h"
+#include "OptionsTuner.h"
+#include "QrRenderer.h"
+#include "ResultExporter.h"
 #include "ScreenshooterXdg.h"
+#include "SequenceAssembler.h"
 #include "ScreenshooterX11.h"
 
 #ifdef WITH_CAMERA
@@ -86,7 +105,7 @@ public:
   ImageDisplayWidget(QWidget *parent = nullptr) : QWidget(parent) {
     QHBoxLayout *layout = new QHBoxLayout(this);
 
-    QVBoxLayout *leftLayout = new QVBoxLayout;
+    leftLayout = new QVBoxLayout;
     layout->addLayout(leftLayout);
 
     imageLabel = new QLabel(this);
@@ -94,13 +113,6 @@ public:
     imageLabel->setText("Drop image here");
     imageLabel->setAlignment(Qt::AlignCenter);
     leftLayout->addWidget(imageLabel);
-    
-#ifdef WITH_CAMERA
-    camera = new WebcamQRCodeWidget();
-    camera->setVisible(false);
-    leftLayout->addWidget(camera);
-    QObject::connect(camera, &WebcamQRCodeWidget::qrCodeDetected, this, &ImageDisplayWidget::qrCodeDetected);
-#endif
 
     QPushButton *openButton = new QPushButton("Open Image", this);
     leftLayout->addWidget(openButton);
@@ -118,6 +130,11 @@ public:
     connect(screenshotButton, &QPushButton::clicked, this,
             &ImageDisplayWidget::makeScreenshot);
 
+    QPushButton *historyButton = new QPushButton("History", this);
+    leftLayout->addWidget(historyButton);
+    connect(historyButton, &QPushButton::clicked, this,
+            &ImageDisplayWidget::showHistory);
+
 #ifdef WITH_CAMERA    
     QPushButton *cameraButton = new QPushButton("Camera", this);
     leftLayout->addWidget(cameraButton);
@@ -139,16 +156,40 @@ public:
     otpauthLineEdit->setReadOnly(true);
     otpauthLineEdit->setVisible(false);
     rightLayout->addWidget(otpauthLineEdit);
+    QAction *saveQrAction = otpauthLineEdit->addAction(
+        QIcon::fromTheme("document-save"), QLineEdit::TrailingPosition);
+    saveQrAction->setToolTip("Save as a clean QR code");
+    connect(saveQrAction, &QAction::triggered, this,
+            &ImageDisplayWidget::saveQrCode);
 
     paramListWidget = new QListWidget(this);
     paramListWidget->setVisible(false);
     rightLayout->addWidget(paramListWidget);
 
+    progressLabel = new QLabel(this);
+    progressLabel->setVisible(false);
+    rightLayout->addWidget(progressLabel);
+
     setAcceptDrops(true);
-    
-    // Connect to the screenshotCaptured signal
-    QObject::connect(&screenshooterXdg, &ScreenshooterXdg::screenshotCaptured, this, &ImageDisplayWidget::capturedImage);
-    
+
+    connect(&decodeWatcher, &QFutureWatcher<QList<PageResult>>::finished,
+            [this]() {
+              if (!decodeWatcher.isCanceled()) {
+                recordHistory("Image", decodeWatcher.result());
+                displayPageResults(decodeWatcher.result());
+              }
+            });
+    connect(&ingestQueue, &IngestQueue::sourceDecoded, this,
+            &ImageDisplayWidget::sourceDecoded);
+    connect(&ingestQueue, &IngestQueue::progress, this,
+            &ImageDisplayWidget::ingestProgress);
+    connect(&previewWatcher, &QFutureWatcher<QImage>::finished,
+            [this]() { previewReady(); });
+  }
+
+  ~ImageDisplayWidget() {
+    // The history view holds queries on the database, it goes first.
+    delete historyDialog;
   }
 
 protected:
@@ -161,20 +202,19 @@ protected:
 
   void dropEvent(QDropEvent *event) override {
     QImage image;
+    QStringList filePaths;
     if (extractImageFromMimeData(event->mimeData(), image)) {
       displayImageFromImage(image);
       decodeBarcodes(image);
+    } else if (extractFilesFromMimeData(event->mimeData(), filePaths)) {
+      decodeFiles(filePaths);
     } else if (event->mimeData()->hasText()) {
       QString droppedText = event->mimeData()->text();
       if (isOtpAuthUrl(droppedText)) {
         displayImageFromThemeIcon("text-x-generic");
         displayOtpAuthUrl(droppedText);
       } else {
-        QString dataUrl = findDataUrl(droppedText);
-        if (!dataUrl.isEmpty()) {
-          displayImageFromDataUrl(dataUrl);
-          decodeBarcodes(this->pixmap.toImage());
-        }
+        decodeDataUrls(DataUrlScanner::scan(droppedText));
       }
     }
     event->acceptProposedAction();
@@ -182,12 +222,11 @@ protected:
 
 private slots:
   void openImage() {
-    QString filePath =
-        QFileDialog::getOpenFileName(this, "Open Image", QString(),
-                                     "Image Files (*.png *.jpg *.jpeg *.bmp)");
-    if (!filePath.isEmpty()) {
-      displayImageFromFile(filePath);
-      decodeBarcodes(QImageReader(filePath).read());
+    QStringList filePaths =
+        QFileDialog::getOpenFileNames(this, "Open Image", QString(),
+                                      ImageDecoder::fileDialogFilter());
+    if (!filePaths.isEmpty()) {
+      decodeFiles(filePaths);
     }
   }
   
@@ -197,7 +236,12 @@ private slots:
       displayImageFromImage(screenshot);
       decodeBarcodes(screenshot);
     } else {
-      screenshooterXdg.takeScreenshot();
+      if (!screenshooterXdg) {
+        // Created on first use, DBus is only needed for the portal.
+        screenshooterXdg = new ScreenshooterXdg(this);
+        QObject::connect(screenshooterXdg, &ScreenshooterXdg::screenshotCaptured, this, &ImageDisplayWidget::capturedImage);
+      }
+      screenshooterXdg->takeScreenshot();
     }
   }
   
@@ -209,9 +253,12 @@ private slots:
   void pasteImage() {
     const QClipboard *clipboard = QApplication::clipboard();
     QImage image;
+    QStringList filePaths;
     if (extractImageFromMimeData(clipboard->mimeData(), image)) {
       displayImageFromImage(image);
       decodeBarcodes(image);
+    } else if (extractFilesFromMimeData(clipboard->mimeData(), filePaths)) {
+      decodeFiles(filePaths);
     } else {
       // Check if pasted text contains a data URL
       QString pastedText = clipboard->text();
@@ -220,22 +267,41 @@ private slots:
           displayImageFromThemeIcon("text-x-generic");
           displayOtpAuthUrl(pastedText);
         } else {
-          QString dataUrl = findDataUrl(pastedText);
-          if (!dataUrl.isEmpty()) {
-            displayImageFromDataUrl(dataUrl);
-            decodeBarcodes(this->pixmap.toImage());
-          }
+          decodeDataUrls(DataUrlScanner::scan(pastedText));
         }
       }
     }
   }
   
+#ifdef WITH_CAMERA
   void startCamera() {
+    if (!camera) {
+      // The camera widget enumerates devices, it is built on first use.
+      camera = new WebcamQRCodeWidget();
+      camera->setVisible(false);
+      leftLayout->insertWidget(leftLayout->indexOf(imageLabel) + 1, camera);
+      QObject::connect(camera, &WebcamQRCodeWidget::qrCodeDetected, this, &ImageDisplayWidget::cameraCodeDetected);
+      QObject::connect(camera, &WebcamQRCodeWidget::qrCodeDetected, this,
+                       [this](const QList<Result> &barcodes) {
+                         recordHistory("Camera", {{0, barcodes}});
+                       });
+    }
+    // A sequence starts over with every camera session.
+    sequenceAssembler.reset();
     imageLabel->setVisible(false);
-    if (camera) {
-      camera->setVisible(true);
+    camera->setVisible(true);
+  }
+
+  // Parts of a multi-code sequence are shown one after the other, they are
+  // only collected from the camera.
+  void cameraCodeDetected(const QList<Result> &barcodes) {
+    if (sequenceAssembler.add(barcodes)) {
+      displaySequence();
+      return;
     }
+    qrCodeDetected(barcodes);
   }
+#endif
   
   void qrCodeDetected(const QList<Result> &barcodes) {
     if (barcodes.size() == 1 && isOtpAuthUrl(barcodes[0].text())) {
@@ -251,76 +317,150 @@ private:
     if (mimeData->hasImage()) {
       image = qvariant_cast<QImage>(mimeData->imageData());
       return true;
-    } else if (mimeData->hasUrls()) {
+    }
+    return false;
+  }
+
+  bool extractFilesFromMimeData(const QMimeData *mimeData,
+                                QStringList &filePaths) {
+    if (mimeData->hasUrls()) {
       QList<QUrl> urlList = mimeData->urls();
       foreach (const QUrl &url, urlList) {
         QString filePath = url.toLocalFile();
         if (!filePath.isEmpty()) {
-          QPixmap pixmap(filePath);
-          image = pixmap.toImage();
-          return true;
+          filePaths.append(filePath);
         }
       }
     }
-    return false;
-  }
-
-  QString findDataUrl(const QString &text) {
-    QRegularExpression regex("data:image/[a-zA-Z]+;base64,[\\w\\d+/=\\s]+");
-    QRegularExpressionMatch match = regex.match(text);
-    if (match.hasMatch()) {
-      return match.captured(0);
-    }
-    return QString();
+    return !filePaths.isEmpty();
   }
 
+  // Only a preview sized copy of an image is kept, it is read at that size
+  // from the encoded source in the background, alongside the decode, while
+  // the label shows a placeholder.
   void displayImageFromFile(const QString &filePath) {
-    QPixmap pixmap(filePath);
-    displayImageFromPixmap(pixmap);
+    QSize size = imageLabel->size();
+    displayPreview(QtConcurrent::run([filePath, size]() {
+      return ImageDecoder::readPreview(
+          {filePath, QByteArray(), QByteArray(), QString()}, size);
+    }));
   }
 
   void displayImageFromImage(const QImage &image) {
-    QPixmap pixmap = QPixmap::fromImage(image);
-    displayImageFromPixmap(pixmap);
+    QSize size = imageLabel->size();
+    displayPreview(QtConcurrent::run([image, size]() {
+      return image.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }));
   }
 
   void displayImageFromThemeIcon(const QString &name) {
-    QPixmap pixmap = QIcon::fromTheme(name).pixmap(imageLabel->size());
-    displayImageFromPixmap(pixmap);
+    previewWatcher.setFuture(QFuture<QImage>());
+    imageLabel->setPixmap(QIcon::fromTheme(name).pixmap(imageLabel->size()));
+    chooseImage();
   }
 
-  void displayImageFromPixmap(const QPixmap &pixmap) {
-    this->pixmap = pixmap;
-    imageLabel->setPixmap(pixmap.scaled(imageLabel->size(), Qt::KeepAspectRatio,
-                                        Qt::SmoothTransformation));
+  void displayPreview(const QFuture<QImage> &preview) {
+    imageLabel->setText("Loading preview...");
+    previewWatcher.setFuture(preview);
     chooseImage();
   }
 
-  void displayImageFromDataUrl(const QString &dataUrl) {
-    QPixmap pixmap;
-    pixmap.loadFromData(QByteArray::fromBase64(dataUrl.split(",")[1].toUtf8()),
-                        "PNG");
-    displayImageFromPixmap(pixmap);
+  void previewReady() {
+    if (previewWatcher.isCanceled()) {
+      return;
+    }
+    QImage preview = previewWatcher.result();
+    if (preview.isNull()) {
+      imageLabel->setText("No preview");
+    } else {
+      imageLabel->setPixmap(QPixmap::fromImage(preview));
+    }
   }
 
-  void decodeBarcodes(const QImage &image) {
-    auto options = ReaderOptions()
-                       .setFormats(ZXing::BarcodeFormat::QRCode)
-                       .setTryInvert(true)
-                       .setTextMode(ZXing::TextMode::HRI)
-                       .setMaxNumberOfSymbols(10);
-    auto barcodes = ReadBarcodes(image, options);
-    if (barcodes.size() == 1 && isOtpAuthUrl(barcodes[0].text())) {
-      displayOtpAuthUrl(barcodes[0].text());
-    } else {
-      displayTextResult(barcodes);
+  void displayImageFromData(const QByteArray &data, const QByteArray &format) {
+    QSize size = imageLabel->size();
+    displayPreview(QtConcurrent::run([data, format, size]() {
+      return ImageDecoder::readPreview({QString(), data, format, QString()},
+                                       size);
+    }));
+  }
+
+  void decodeFiles(const QStringList &filePaths) {
+    displayImageFromFile(filePaths.first());
+
+    QList<ImageSource> sources;
+    for (const QString &filePath : filePaths) {
+      sources.append({filePath, QByteArray(), QByteArray(),
+                      QFileInfo(filePath).fileName()});
+    }
+    decodeSources(sources);
+  }
+
+  void decodeDataUrls(const QList<DataUrlImage> &images) {
+    if (images.isEmpty()) {
+      return;
     }
+    displayImageFromData(images.first().data, images.first().format);
+
+    QList<ImageSource> sources;
+    for (const DataUrlImage &image : images) {
+      sources.append({QString(), image.data, image.format,
+                      QString("Image %1").arg(sources.size() + 1)});
+    }
+    decodeSources(sources);
+  }
+
+  void decodeSources(const QList<ImageSource> &sources) {
+    // Sources are decoded in parallel, results are collected as they
+    // arrive. A newer request replaces the pending one.
+    decodeWatcher.setFuture(QFuture<QList<PageResult>>());
+    ingestQueue.clear();
+    ingestResults.clear();
+    ingestQueue.setDecoder(decoder);
+    ingestQueue.enqueue(sources);
+  }
+
+  void sourceDecoded(const QString &name, const QList<PageResult> &pages) {
+    recordHistory(name, pages);
+    ingestResults += pages;
+    displayPageResults(ingestResults);
+  }
+
+  void ingestProgress(int completed, int total) {
+    progressLabel->setText(
+        QString("Decoded %1 of %2 images").arg(completed).arg(total));
+    progressLabel->setVisible(total > 1);
+  }
+
+  void decodeBarcodes(const QImage &image) {
+    ingestQueue.clear();
+    progressLabel->setVisible(false);
+
+    // The worker holds the last reference to a full resolution image, it
+    // is released as soon as decoding finishes.
+    ImageDecoder decoder = this->decoder;
+    decodeWatcher.setFuture(QtConcurrent::run([decoder, image]() {
+      return QList<PageResult>{{0, decoder.decodeImage(image)}};
+    }));
   }
 
   bool isOtpAuthUrl(const QString &text) {
     return text.startsWith("otpauth://");
   }
 
+  void saveQrCode() {
+    QString fileName = QFileDialog::getSaveFileName(
+        this, "Save QR Code", QString(), "PNG Image (*.png)");
+    if (fileName.isEmpty()) {
+      return;
+    }
+    QImage image = QrRenderer().render(otpauthLineEdit->text());
+    if (image.isNull() || !image.save(fileName, "PNG")) {
+      QMessageBox::warning(this, "Save QR Code",
+                           "The QR code could not be saved.");
+    }
+  }
+
   void displayOtpAuthUrl(const QString &otpauthUrl) {
     QUrl url(otpauthUrl);
 
@@ -413,11 +553,117 @@ private:
     return QString();
   }
 
+  void displayPageResults(const QList<PageResult> &pages) {
+    QList<Result> barcodes;
+    for (const PageResult &page : pages) {
+      barcodes += page.barcodes;
+    }
+    if (pages.size() <= 1 ||
+        (barcodes.size() == 1 && isOtpAuthUrl(barcodes[0].text()))) {
+      qrCodeDetected(barcodes);
+      return;
+    }
+
+    QSet<QString> multiPageSources;
+    for (const PageResult &page : pages) {
+      if (page.page > 0) {
+        multiPageSources.insert(page.source);
+      }
+    }
+
+    QString resultText;
+    for (const PageResult &page : pages) {
+      if (page.barcodes.isEmpty()) {
+        continue;
+      }
+      if (page.source.isEmpty()) {
+        resultText += QString("Page %1:\n").arg(page.page + 1);
+      } else if (multiPageSources.contains(page.source)) {
+        resultText += QString("%1, page %2:\n").arg(page.source).arg(page.page + 1);
+      } else {
+        resultText += page.source + ":\n";
+      }
+      for (const auto &result : page.barcodes) {
+        resultText += result.text() + "\n";
+      }
+      resultText += "\n";
+    }
+    displayText(resultText);
+  }
+
   void displayTextResult(const QList<Result> &barcodes) {
     QString resultText;
     for (const auto &result : barcodes) {
       resultText += result.text() + "\n";
     }
+    displayText(resultText);
+  }
+
+  void displaySequence() {
+    QStringList texts = sequenceAssembler.texts();
+    if (sequenceAssembler.isComplete()) {
+      if (texts.size() == 1 && isOtpAuthUrl(texts[0])) {
+        displayOtpAuthUrl(texts[0]);
+      } else {
+        displayText(QString("All %1 parts captured\n\n%2")
+                        .arg(sequenceAssembler.total())
+                        .arg(texts.join("\n")));
+      }
+      return;
+    }
+
+    QStringList missing;
+    for (int index : sequenceAssembler.missing()) {
+      missing << QString::number(index + 1);
+    }
+    displayText(QString("%1 of %2 captured, missing: %3\n\n%4")
+                    .arg(sequenceAssembler.captured())
+                    .arg(sequenceAssembler.total())
+                    .arg(missing.join(", "))
+                    .arg(texts.join("\n")));
+  }
+
+  // The history database is opened on the first decode or when the history
+  // is shown, not at startup.
+  DecodeHistory *decodeHistory() {
+    if (!history) {
+      history.reset(new DecodeHistory);
+    }
+    return history.data();
+  }
+
+  void recordHistory(const QString &source, const QList<PageResult> &pages) {
+    if (!DecodeHistory::isRecording()) {
+      return;
+    }
+    for (const PageResult &page : pages) {
+      decodeHistory()->record(source, page.barcodes);
+    }
+    if (historyDialog && historyDialog->isVisible()) {
+      historyDialog->refresh();
+    }
+  }
+
+  void showHistory() {
+    if (!historyDialog) {
+      historyDialog = new HistoryDialog(decodeHistory(), this);
+      connect(historyDialog, &HistoryDialog::entryActivated, this,
+              [this](const QString &text) {
+                displayImageFromThemeIcon("text-x-generic");
+                if (isOtpAuthUrl(text)) {
+                  displayOtpAuthUrl(text);
+                } else {
+                  displayText(text);
+                }
+              });
+    } else {
+      historyDialog->refresh();
+    }
+    historyDialog->show();
+    historyDialog->raise();
+  }
+
+  void displayText(const QString &resultText) {
     otpauthLineEdit->setVisible(false);
     paramListWidget->setVisible(false);
     resultTextEdit->setText(resultText.trimmed());
@@ -425,31 +671,227 @@ private:
   }
     
   void chooseImage() {
+#ifdef WITH_CAMERA
     if (camera) {
       camera->setVisible(false);
     }
+    // Other input ends a sequence collected from the camera.
+    sequenceAssembler.reset();
+#endif
     imageLabel->setVisible(true);
   }
 
+  QVBoxLayout *leftLayout;
   QLabel *imageLabel;
-  WebcamQRCodeWidget *camera;
+#ifdef WITH_CAMERA
+  WebcamQRCodeWidget *camera = nullptr;
+#endif
   QLineEdit *otpauthLineEdit;
   QListWidget *paramListWidget;
   QTextEdit *resultTextEdit;
-  QPixmap pixmap;
-  ScreenshooterXdg screenshooterXdg;
+  QLabel *progressLabel;
+  ScreenshooterXdg *screenshooterXdg = nullptr;
+  ImageDecoder decoder;
+  SequenceAssembler sequenceAssembler;
+  QFutureWatcher<QList<PageResult>> decodeWatcher;
+  IngestQueue ingestQueue;
+  QList<PageResult> ingestResults;
+  QFutureWatcher<QImage> previewWatcher;
+  QScopedPointer<DecodeHistory> history;
+  HistoryDialog *historyDialog = nullptr;
 
 };
 
+class FirstPaintProbe : public QObject {
+public:
+  bool eventFilter(QObject *watched, QEvent *event) override {
+    if (event->type() == QEvent::Paint && !painted) {
+      painted = true;
+      printf("first-paint-msecs-since-epoch %lld\n",
+             QDateTime::currentMSecsSinceEpoch());
+      fflush(stdout);
+      QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+    }
+    return QObject::eventFilter(watched, event);
+  }
+
+private:
+  bool painted = false;
+};
+
+// Command line modes run without any GUI, DBus or widget setup. Rendering
+// QR sheets needs fonts and thus a QGuiApplication, it runs on the offscreen
+// platform unless QT_QPA_PLATFORM says otherwise, so no display is needed.
+static int runHeadless(int argc, char *argv[], bool withGui) {
+  if (withGui && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+  }
+  QScopedPointer<QCoreApplication> application(
+      withGui ? new QGuiApplication(argc, argv)
+              : new QCoreApplication(argc, argv));
+  QCoreApplication &app = *application;
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Decode QR Codes and URLs containing OTPAUTH information");
+  parser.addHelpOption();
+  QCommandLineOption daemonOption(
+      "daemon", "Serve decode requests on a local socket.");
+  QCommandLineOption clientOption(
+      "client", "Send the images to a running daemon and print the results.");
+  QCommandLineOption socketOption("socket", "Local socket of the daemon.",
+                                  "name", DecodeServer::defaultSocketName());
+  QCommandLineOption exportOption(
+      "export",
+      "Decode the images and write every code as jsonl or csv, - reads "
+      "image paths from stdin.",
+      "format");
+  QCommandLineOption outputOption("output", "Export file instead of stdout.",
+                                  "file");
+  QCommandLineOption renderOption(
+      "render-qr",
+      "Render the URIs of the given text files (stdin if none), one per "
+      "line, as QR codes into a PDF sheet or a directory of PNG files.",
+      "output");
+  QCommandLineOption qrCacheOption(
+      "qr-cache",
+      "Keep rendered QR codes in a user-only disk cache, they contain the "
+      "account secrets.");
+  QCommandLineOption tuneOption(
+      "tune-options",
+      "Decode the images below the directory with every combination of reader "
+      "options and print hit rate, latency and memory of each.",
+      "directory");
+  QCommandLineOption watchOption(
+      "watch",
+      "Decode images dropped into the directory (may be given several "
+      "times), records are written as with --export, jsonl by default.",
+      "directory");
+  QCommandLineOption journalOption(
+      "journal", "Journal of the files already decoded in watch mode.",
+      "file", FolderWatcher::defaultJournalPath());
+  parser.addOptions({daemonOption, clientOption, socketOption, exportOption,
+                     outputOption, renderOption, qrCacheOption, tuneOption,
+                     watchOption, journalOption});
+  parser.addPositionalArgument("images", "Image files, - reads from stdin.",
+                               "[images...]");
+  parser.process(app);
+
+  if (parser.isSet(tuneOption)) {
+    OptionsTuner tuner(ImageDecoder().options());
+    int count = tuner.loadCorpus(parser.value(tuneOption));
+    if (count == 0) {
+      qWarning() << "no images below" << parser.value(tuneOption);
+      return 1;
+    }
+    fprintf(stderr, "sweeping reader options over %d images\n", count);
+    printf("%s\n", qPrintable(OptionsTuner::table(tuner.run())));
+    return 0;
+  }
+
+  if (parser.isSet(renderOption)) {
+    QStringList uris;
+    QStringList inputs = parser.positionalArguments();
+    if (inputs.isEmpty()) {
+      inputs << "-";
+    }
+    for (const QString &input : inputs) {
+      QFile file(input);
+      if (!(input == "-" ? file.open(stdin, QIODevice::ReadOnly)
+                         : file.open(QIODevice::ReadOnly))) {
+        qWarning() << "failed to open" << input;
+        return 1;
+      }
+      while (!file.atEnd()) {
+        QString uri = QString::fromUtf8(file.readLine()).trimmed();
+        if (!uri.isEmpty()) {
+          uris << uri;
+        }
+      }
+    }
+    const QString output = parser.value(renderOption);
+    QrRenderer renderer(parser.isSet(qrCacheOption)
+                            ? QrRenderer::defaultCacheDir()
+                            : QString());
+    int written = output.endsWith(".pdf", Qt::CaseInsensitive)
+                      ? renderer.writeSheet(uris, output)
+                      : renderer.writePngSet(uris, output);
+    return written == uris.size() ? 0 : 1;
+  }
+
+  if (parser.isSet(exportOption) || parser.isSet(watchOption)) {
+    ResultExporter::Format format = ResultExporter::JsonLines;
+    if (parser.isSet(exportOption) &&
+        !ResultExporter::formatFromName(parser.value(exportOption), format)) {
+      qWarning() << "unknown export format" << parser.value(exportOption);
+      return 1;
+    }
+    QFile output;
+    if (parser.isSet(outputOption)) {
+      output.setFileName(parser.value(outputOption));
+      if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "failed to open" << output.fileName() << ":"
+                   << output.errorString();
+        return 1;
+      }
+    } else {
+      output.open(stdout, QIODevice::WriteOnly);
+    }
+    ResultExporter exporter(&output, format);
+    if (parser.isSet(watchOption)) {
+      FolderWatcher watcher(&exporter, parser.value(journalOption));
+      for (const QString &directory : parser.values(watchOption)) {
+        if (!watcher.watch(directory)) {
+          return 1;
+        }
+      }
+      return app.exec();
+    }
+    return ExportJob(parser.positionalArguments(), &exporter).exec();
+  }
+
+  if (parser.isSet(daemonOption)) {
+    DecodeServer server;
+    if (!server.listen(parser.value(socketOption))) {
+      return 1;
+    }
+    return app.exec();
+  }
+  return DecodeClient(parser.value(socketOption))
+      .run(parser.positionalArguments());
+}
+
 int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    if (qstrcmp(argv[i], "--daemon") == 0 ||
+        qstrcmp(argv[i], "--client") == 0 ||
+        qstrncmp(argv[i], "--export", 8) == 0 ||
+        qstrncmp(argv[i], "--tune-options", 14) == 0 ||
+        qstrncmp(argv[i], "--watch", 7) == 0) {
+      return runHeadless(argc, argv, false);
+    }
+    if (qstrncmp(argv[i], "--render-qr", 11) == 0) {
+      return runHeadless(argc, argv, true);
+    }
+  }
+
   QApplication app(argc, argv);
 
+  // Startup benchmark: print the wall clock time of the first paint and
+  // quit, see tools/startup-benchmark.sh.
+  FirstPaintProbe firstPaintProbe;
+  const bool startupBenchmark =
+      app.arguments().contains("--startup-benchmark");
+
   QMainWindow mainWindow;
   mainWindow.setAttribute(Qt::WA_X11NetWmWindowTypeDialog);
   mainWindow.resize(680, 450);
   ImageDisplayWidget *imageDisplayWidget = new ImageDisplayWidget(&mainWindow);
   mainWindow.setCentralWidget(imageDisplayWidget);
   mainWindow.setWindowTitle("OTPAuth Decoder");
+  if (startupBenchmark) {
+    mainWindow.installEventFilter(&firstPaintProbe);
+  }
   mainWindow.show();
 
   return app.exec();
@@ -8,7 +8,7 @@ INCLUDEPATH += .
 CONFIG+=link_pkgconfig
 PKGCONFIG=zxing
 
-QT+=core widgets dbus
+QT+=core widgets dbus concurrent network sql
 
 # You can make your code fail to compile if you use deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -18,12 +18,27 @@ QT+=core widgets dbus
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 # Input
-SOURCES += main.cpp ScreenshooterXdg.cpp
-HEADERS += ScreenshooterXdg.h ScreenshooterX11.h ZXingQt/ZXingQtReader.h
+SOURCES += main.cpp DataUrlScanner.cpp DecodeHistory.cpp DecodeServer.cpp FolderWatcher.cpp ImageDecoder.cpp IngestQueue.cpp MappedImage.cpp MimeImageScanner.cpp OptionsTuner.cpp OtpAuthUri.cpp QrRenderer.cpp ResultExporter.cpp ScreenshooterXdg.cpp SequenceAssembler.cpp
+HEADERS += Base64Decoder.h DataUrlScanner.h DecodeHistory.h DecodeServer.h DecodeSession.h FolderWatcher.h ImageDecoder.h IngestQueue.h MappedImage.h MimeImageScanner.h OptionsTuner.h OtpAuthUri.h QrRenderer.h ResultExporter.h ScreenshooterXdg.h ScreenshooterX11.h SequenceAssembler.h ZXingQt/ZXingQtReader.h
 
 CAMERA {
     QT += qml multimedia multimediawidgets concurrent
-    SOURCES += WebcamQRCodeWidget.cpp
-    HEADERS += WebcamQRCodeWidget.h
+    PKGCONFIG += libjpeg
+    SOURCES += DecodeScheduler.cpp FrameQualityFilter.cpp JpegLumaDecoder.cpp LumaConverter.cpp LumaPyramid.cpp WebcamQRCodeWidget.cpp
+    HEADERS += DecodeScheduler.h FrameBufferPool.h FrameQualityFilter.h JpegLumaDecoder.h LumaConverter.h LumaPyramid.h WebcamQRCodeWidget.h
     DEFINES += WITH_CAMERA=1
 }
+
+ARCHIVE {
+    PKGCONFIG += libarchive
+    SOURCES += ArchiveImageReader.cpp
+    HEADERS += ArchiveImageReader.h
+    DEFINES += WITH_ARCHIVE=1
+}
+
+PDF {
+    QT += pdf
+    SOURCES += PdfRasterizer.cpp
+    HEADERS += PdfRasterizer.h
+    DEFINES += WITH_PDF=1
+}
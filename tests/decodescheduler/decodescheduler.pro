@@ -0,0 +1,10 @@
+TEMPLATE = app
+TARGET = tst_decodescheduler
+INCLUDEPATH += ../..
+CONFIG += testcase
+
+QT += core testlib
+QT -= gui
+
+SOURCES += tst_decodescheduler.cpp ../../DecodeScheduler.cpp
+HEADERS += ../../DecodeScheduler.h
@@ -0,0 +1,63 @@
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtTest>
+
+#include "DecodeScheduler.h"
+
+// Feeds the scheduler camera frames in real time with made up CPU costs
+// and checks that decodes keep happening at budgets where the JPEG decode
+// and frame filter of every frame alone would exceed the budget.
+class DecodeSchedulerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void smallBudget_data();
+    void smallBudget();
+};
+
+void DecodeSchedulerTest::smallBudget_data() {
+    QTest::addColumn<double>("budget");
+    QTest::addColumn<int>("frameInterval"); // ms, all cameras together
+    QTest::addColumn<double>("probeCost");  // ms, JPEG decode and filter
+    QTest::addColumn<double>("decodeCost"); // ms, including the probe
+
+    QTest::newRow("10%, one 1080p MJPEG camera") << 0.1 << 33 << 4.0 << 40.0;
+    QTest::newRow("25%, two 1080p MJPEG cameras") << 0.25 << 16 << 4.5 << 40.0;
+}
+
+void DecodeSchedulerTest::smallBudget() {
+    QFETCH(double, budget);
+    QFETCH(int, frameInterval);
+    QFETCH(double, probeCost);
+    QFETCH(double, decodeCost);
+
+    DecodeScheduler scheduler(budget);
+    int decodes = 0;
+    double charged = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 2000) {
+        switch (scheduler.admit()) {
+        case DecodeScheduler::Decode:
+            ++decodes;
+            charged += decodeCost;
+            scheduler.finished(qint64(decodeCost * 1e6), DecodeScheduler::Motion, true);
+            break;
+        case DecodeScheduler::Probe:
+            charged += probeCost;
+            scheduler.finished(qint64(probeCost * 1e6), DecodeScheduler::Motion, false);
+            break;
+        case DecodeScheduler::Drop:
+            break;
+        }
+        QThread::msleep(frameInterval);
+    }
+
+    // Without a share reserved for them, decodes would stop after the
+    // first one here.
+    QVERIFY2(decodes >= 2, qPrintable(scheduler.report()));
+    QVERIFY2(charged <= budget * timer.elapsed() + decodeCost + probeCost, qPrintable(scheduler.report()));
+}
+
+QTEST_GUILESS_MAIN(DecodeSchedulerTest)
+#include "tst_decodescheduler.moc"
@@ -0,0 +1,11 @@
+TEMPLATE = app
+TARGET = tst_framepool
+INCLUDEPATH += ../..
+CONFIG += link_pkgconfig testcase
+PKGCONFIG = zxing libjpeg
+
+QT += core gui testlib
+QT -= widgets
+
+SOURCES += tst_framepool.cpp ../../FrameQualityFilter.cpp ../../JpegLumaDecoder.cpp ../../LumaConverter.cpp ../../LumaPyramid.cpp
+HEADERS += ../../FrameBufferPool.h ../../FrameQualityFilter.h ../../JpegLumaDecoder.h ../../LumaConverter.h ../../LumaPyramid.h ../../ZXingQt/ZXingQtReader.h
@@ -0,0 +1,144 @@
+#include <QBuffer>
+#include <QImage>
+#include <QtTest>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "FrameBufferPool.h"
+#include "FrameQualityFilter.h"
+#include "JpegLumaDecoder.h"
+#include "LumaConverter.h"
+#include "LumaPyramid.h"
+
+// Every heap allocation of the test process goes through these, operator
+// new as well as Qt's containers (which use malloc directly). glibc only.
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *pointer, size_t size);
+
+static std::atomic<size_t> countedSize{0};
+static std::atomic<int> largeAllocations{0};
+
+static void *counted(void *pointer, size_t size) {
+    const size_t limit = countedSize.load();
+    if (limit > 0 && size >= limit) {
+        ++largeAllocations;
+    }
+    return pointer;
+}
+
+extern "C" void *malloc(size_t size) noexcept {
+    return counted(__libc_malloc(size), size);
+}
+
+extern "C" void *calloc(size_t count, size_t size) noexcept {
+    return counted(__libc_calloc(count, size), count * size);
+}
+
+extern "C" void *realloc(void *pointer, size_t size) noexcept {
+    return counted(__libc_realloc(pointer, size), size);
+}
+
+void *operator new(size_t size) {
+    void *pointer = malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    free(pointer);
+}
+
+// Scans frames the way the camera pipeline does, without zxing itself
+// (its binarizer allocates per frame), and checks that once every frame
+// size has been seen no pixel buffer is allocated anymore.
+class FramePoolTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void steadyStateScanning();
+
+private:
+    // Alternating frames, so the filter sees motion and passes them on.
+    QImage frames[2];
+    QByteArray jpegFrames[2];
+};
+
+void FramePoolTest::initTestCase() {
+    for (int i = 0; i < 2; ++i) {
+        // Checkerboards of 40 pixel squares, the second one inverted.
+        frames[i] = QImage(1280, 960, QImage::Format_RGB32);
+        for (int y = 0; y < frames[i].height(); ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(frames[i].scanLine(y));
+            for (int x = 0; x < frames[i].width(); ++x) {
+                line[x] = (x / 40 + y / 40 + i) % 2 ? qRgb(0, 0, 0) : qRgb(255, 255, 255);
+            }
+        }
+        QBuffer buffer(&jpegFrames[i]);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(frames[i].save(&buffer, "JPEG"));
+    }
+}
+
+void FramePoolTest::steadyStateScanning() {
+    FrameBufferPool pool;
+    FrameQualityFilter filter;
+    JpegLumaDecoder jpeg(&pool);
+    LumaConverter luma(&pool);
+    LumaPyramid pyramid(&pool);
+    int levels = 0;
+    auto scan = [&](const ZXing::ImageView &image) {
+        filter.check(image);
+        pyramid.decode(image, [&](const ZXing::ImageView &) {
+            ++levels;
+            return QList<ZXingQt::Result>();
+        });
+    };
+    auto scanFrames = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            QVERIFY(jpeg.decode(reinterpret_cast<const uchar *>(jpegFrames[i % 2].constData()),
+                                size_t(jpegFrames[i % 2].size())));
+            scan(jpeg.image());
+            QVERIFY(luma.convert(frames[i % 2]));
+            scan(luma.image());
+        }
+    };
+
+    scanFrames(4);
+    const int warmAllocations = pool.allocations();
+    QVERIFY(warmAllocations > 0);
+
+    // The smallest buffer the pool hands out: the coarsest pyramid level
+    // of the JPEG frames, decoded at half size.
+    countedSize = 320 * 240;
+    levels = 0;
+    scanFrames(50);
+    countedSize = 0;
+
+    QVERIFY(levels >= 100);
+    QCOMPARE(pool.allocations(), warmAllocations);
+    QCOMPARE(largeAllocations.load(), 0);
+}
+
+QTEST_GUILESS_MAIN(FramePoolTest)
+#include "tst_framepool.moc"
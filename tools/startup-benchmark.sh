@@ -0,0 +1,99 @@
+#!/usr/bin/env bash
+#
+# Measures the time from process start to the first paint of the main
+# window on the offscreen platform. With --client, measures instead how long
+# a decode of the image takes as a round trip to a running daemon, against
+# decoding it in a cold process with --export.
+#
+# usage: tools/startup-benchmark.sh [--client image] [path/to/qotpdecode] [runs]
+
+IMAGE=
+if [ "$1" = "--client" ]; then
+    IMAGE=$2
+    shift 2
+    if [ ! -r "$IMAGE" ]; then
+        echo "image not readable: $IMAGE" >&2
+        exit 1
+    fi
+fi
+
+BINARY=${1:-./qotpdecode}
+RUNS=${2:-20}
+
+if [ ! -x "$BINARY" ]; then
+    echo "qotpdecode binary not found: $BINARY" >&2
+    exit 1
+fi
+
+# $EPOCHREALTIME (bash 5) is portable, unlike the %N format of GNU date.
+if [ -z "$EPOCHREALTIME" ]; then
+    echo "bash 5 or newer is required for \$EPOCHREALTIME" >&2
+    exit 1
+fi
+
+# Milliseconds since the epoch, the decimal separator follows the locale.
+now_ms() {
+    local usecs=${EPOCHREALTIME//[.,]/}
+    echo $((usecs / 1000))
+}
+
+# Reads one duration in ms per line, prints the statistics prefixed by $1.
+summarize() {
+    sort -n | awk -v label="$1" '
+        { ms[NR] = $1; sum += $1 }
+        END {
+            printf "%sruns: %d  min: %d ms  median: %d ms  mean: %.1f ms  max: %d ms\n",
+                   label, NR, ms[1], ms[int((NR + 1) / 2)], sum / NR, ms[NR]
+        }'
+}
+
+# Prints the wall clock time of each of $RUNS runs of the command.
+time_runs() {
+    local i=0 start
+    while [ "$i" -lt "$RUNS" ]; do
+        start=$(now_ms)
+        if ! "$@" > /dev/null; then
+            echo "run $i failed: $*" >&2
+            return 1
+        fi
+        echo $(($(now_ms) - start))
+        i=$((i + 1))
+    done
+}
+
+export QT_QPA_PLATFORM=offscreen
+
+if [ -n "$IMAGE" ]; then
+    set -o pipefail
+    SOCKET_DIR=$(mktemp -d)
+    SOCKET=$SOCKET_DIR/qotpdecode.sock
+    "$BINARY" --daemon --socket "$SOCKET" &
+    DAEMON=$!
+    trap 'kill "$DAEMON" 2> /dev/null; rm -rf "$SOCKET_DIR"' EXIT
+    # The first request also waits for the daemon to listen.
+    i=0
+    until "$BINARY" --client --socket "$SOCKET" "$IMAGE" > /dev/null 2>&1; do
+        i=$((i + 1))
+        if [ "$i" -ge 50 ]; then
+            echo "daemon did not start" >&2
+            exit 1
+        fi
+        sleep 0.1
+    done
+
+    time_runs "$BINARY" --export jsonl "$IMAGE" | summarize "cold --export:   " || exit 1
+    time_runs "$BINARY" --client --socket "$SOCKET" "$IMAGE" | summarize "daemon --client: " || exit 1
+    exit 0
+fi
+
+i=0
+while [ "$i" -lt "$RUNS" ]; do
+    start=$(now_ms)
+    painted=$("$BINARY" --startup-benchmark | awk '/^first-paint-msecs-since-epoch/ { print $2 }')
+    if [ -z "$painted" ]; then
+        echo "run $i: no first paint reported" >&2
+        exit 1
+    fi
+    echo $((painted - start))
+    i=$((i + 1))
+done | summarize ""